@@ -168,6 +168,31 @@ namespace bridge
 		/// <param name="obj">Object.</param>
 		void						Release (object obj);
 
+
+		/// <summary>
+		/// Resolves a method once, returning a handle with which it can be invoked
+		/// </summary>
+		/// <param name="classname">class name.</param>
+		/// <param name="method">Method name.</param>
+		/// <param name="argtypes">Argument type names, or null if the method name is not overloaded.</param>
+		int							Prepare (string classname, string method, string[] argtypes);
+
+
+		/// <summary>
+		/// Invokes a prepared method (the first parameter is the target object for instance methods)
+		/// </summary>
+		/// <param name="handle">Handle returned by Prepare.</param>
+		/// <param name="parameters">Parameters.</param>
+		object						Invoke (int handle, params object[] parameters);
+
+
+		/// <summary>
+		/// Reads the named properties of each element of a collection, returning one typed array (column) per property
+		/// </summary>
+		/// <param name="collection">Collection.</param>
+		/// <param name="properties">Property names.</param>
+		object[]					Project (object collection, params string[] properties);
+
 	}
 }
 
@@ -21,6 +21,9 @@
 //
 
 using System;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Reflection;
 using bridge.common.reflection;
 using bridge;
 
@@ -201,6 +204,160 @@ namespace bridge.embedded
 		{
 		}
 
+
+		/// <summary>
+		/// Resolves a method once, returning a handle with which it can be invoked
+		/// </summary>
+		/// <param name="classname">class name.</param>
+		/// <param name="method">Method name.</param>
+		/// <param name="argtypes">Argument type names, or null if the method name is not overloaded.</param>
+		public int Prepare (string classname, string method, string[] argtypes)
+		{
+			var signature = classname + "::" + method + (argtypes != null ? "(" + string.Join (",", argtypes) + ")" : "");
+
+			int handle = 0;
+			if (_handles.TryGetValue (signature, out handle))
+				return handle;
+
+			var type = ReflectUtils.FindType (classname);
+			if (type == null)
+				throw new ArgumentException ("Prepare: could not find specified type: " + classname);
+
+			var imethod = (argtypes != null) ? FindMethod (type, method, argtypes) : FindMethod (type, method);
+			lock (_methods)
+			{
+				if (_handles.TryGetValue (signature, out handle))
+					return handle;
+
+				handle = _methods.Count;
+				_methods.Add (imethod);
+				_handles[signature] = handle;
+				return handle;
+			}
+		}
+
+
+		/// <summary>
+		/// Invokes a prepared method (the first parameter is the target object for instance methods)
+		/// </summary>
+		/// <param name="handle">Handle returned by Prepare.</param>
+		/// <param name="parameters">Parameters.</param>
+		public object Invoke (int handle, params object[] parameters)
+		{
+			MethodInfo method = null;
+			lock (_methods)
+			{
+				if (handle < 0 || handle >= _methods.Count)
+					throw new ArgumentException ("Invoke: unknown method handle: " + handle);
+				method = _methods[handle];
+			}
+
+			if (method.IsStatic)
+				return ReflectUtils.InvokeMethod (null, method, parameters);
+
+			if (parameters.Length == 0 || parameters[0] == null)
+				throw new ArgumentException ("Invoke: instance method " + method.Name + " requires the target object as first argument");
+
+			var args = new object[parameters.Length - 1];
+			Array.Copy (parameters, 1, args, 0, args.Length);
+			return ReflectUtils.InvokeMethod (parameters[0], method, args);
+		}
+
+
+		/// <summary>
+		/// Reads the named properties of each element of a collection, returning one typed array (column) per property
+		/// </summary>
+		/// <param name="collection">Collection.</param>
+		/// <param name="properties">Property names.</param>
+		public object[] Project (object collection, params string[] properties)
+		{
+			return PropertyProjector.Project (collection, properties);
+		}
+
+
+		#region Implementation
+
+
+		/// <summary>
+		/// Find method with exactly the given argument types
+		/// </summary>
+		private static MethodInfo FindMethod (Type type, string name, string[] argtypes)
+		{
+			var types = new Type[argtypes.Length];
+			for (int i = 0 ; i < argtypes.Length ; i++)
+				types[i] = TypeForName (argtypes[i]);
+
+			var method = type.GetMethod (name, types);
+			if (method == null)
+				throw new ArgumentException ("Prepare: could not find method " + name + "(" + string.Join (",", argtypes) + ") in " + type);
+
+			return method;
+		}
+
+
+		/// <summary>
+		/// Find method by name, requiring that it not be overloaded
+		/// </summary>
+		private static MethodInfo FindMethod (Type type, string name)
+		{
+			MethodInfo found = null;
+			foreach (var method in type.GetMethods())
+			{
+				if (method.Name != name)
+					continue;
+				if (found != null)
+					throw new ArgumentException ("Prepare: method " + name + " in " + type + " is overloaded, argument types must be given");
+
+				found = method;
+			}
+
+			if (found == null)
+				throw new ArgumentException ("Prepare: could not find method " + name + " in " + type);
+
+			return found;
+		}
+
+
+		/// <summary>
+		/// Resolve type by name, allowing C# aliases such as double or int[]
+		/// </summary>
+		private static Type TypeForName (string name)
+		{
+			if (name.EndsWith ("[]"))
+				return TypeForName (name.Substring (0, name.Length - 2)).MakeArrayType();
+
+			Type type = null;
+			if (_aliases.TryGetValue (name, out type))
+				return type;
+
+			type = ReflectUtils.FindType (name);
+			if (type == null)
+				throw new ArgumentException ("Prepare: could not find argument type: " + name);
+
+			return type;
+		}
+
+
+		#endregion
+
+		// Variables
+
+		static IDictionary<string,int>		_handles = new ConcurrentDictionary<string, int>();
+		static List<MethodInfo>				_methods = new List<MethodInfo>();
+
+		static IDictionary<string,Type>		_aliases = new Dictionary<string, Type>
+		{
+			{ "bool", typeof(bool) },
+			{ "byte", typeof(byte) },
+			{ "char", typeof(char) },
+			{ "short", typeof(short) },
+			{ "int", typeof(int) },
+			{ "long", typeof(long) },
+			{ "float", typeof(float) },
+			{ "double", typeof(double) },
+			{ "string", typeof(string) },
+			{ "object", typeof(object) }
+		};
 	}
 }
 
@@ -280,6 +280,55 @@ namespace bridge.server
 		}
 
 
+		/// <summary>
+		/// Resolves a method once, returning a handle with which it can be invoked
+		/// </summary>
+		/// <param name="classname">class name.</param>
+		/// <param name="method">Method name.</param>
+		/// <param name="argtypes">Argument type names, or null if the method name is not overloaded.</param>
+		public int Prepare (string classname, string method, string[] argtypes)
+		{
+			// send request
+			var req = new CLRPrepareMessage (classname, method, argtypes);
+			CLRMessage.Write (_cout, req);
+			
+			// get response
+			return (int)CLRMessage.ReadValue (_cin);
+		}
+
+
+		/// <summary>
+		/// Invokes a prepared method (the first parameter is the target object for instance methods)
+		/// </summary>
+		/// <param name="handle">Handle returned by Prepare.</param>
+		/// <param name="parameters">Parameters.</param>
+		public object Invoke (int handle, params object[] parameters)
+		{
+			// send request
+			var req = new CLRInvokeMessage (handle, parameters);
+			CLRMessage.Write (_cout, req);
+			
+			// get response
+			return CLRMessage.ReadValue (_cin);
+		}
+
+
+		/// <summary>
+		/// Reads the named properties of each element of a collection, returning one typed array (column) per property
+		/// </summary>
+		/// <param name="collection">Collection.</param>
+		/// <param name="properties">Property names.</param>
+		public object[] Project (object collection, params string[] properties)
+		{
+			// send request
+			var req = new CLRProjectMessage (collection, properties);
+			CLRMessage.Write (_cout, req);
+			
+			// get response
+			return (object[])CLRMessage.ReadValue (_cin);
+		}
+
+
 		#region Implementation
 		
 		
@@ -21,6 +21,7 @@
 //
 
 using System;
+using System.IO;
 using System.Threading;
 using System.Net;
 using System.Net.Sockets;
@@ -38,6 +39,10 @@ namespace bridge.server
 		public CLRBridgeServer (Uri url)
 			: this (url.Port)
 		{
+			if (url.Scheme == "unix")
+				_path = url.AbsolutePath;
+			if (url.Scheme == "shm")
+				_shm_path = url.AbsolutePath;
 		}
 
 		public CLRBridgeServer(int port)
@@ -63,12 +68,12 @@ namespace bridge.server
 
 			if (!blocking)
 			{
-				var worker = new Thread(_ => Service());
+				var worker = new Thread(_ => Serve());
 				worker.Start();
 			}
 			else
 			{
-				Service ();
+				Serve ();
 			}
 		}
 
@@ -82,6 +87,11 @@ namespace bridge.server
 		/// </summary>
 		private bool SetupListener ()
 		{
+			if (_path != null)
+				return SetupUnixListener ();
+			if (_shm_path != null)
+				return SetupSharedMemory ();
+
 			_log.Info("starting execution server listener on port: " + _port);
 			var mask = new IPEndPoint(IPAddress.Any, _port);
 			_server_socket = new Socket(AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
@@ -105,6 +115,82 @@ namespace bridge.server
 		}
 
 
+		/// <summary>
+		/// Setup server on a unix domain socket (same-host clients, avoids the TCP/IP stack)
+		/// </summary>
+		private bool SetupUnixListener ()
+		{
+			_log.Info("starting execution server listener on unix socket: " + _path);
+			var mask = new UnixEndPoint (_path);
+
+			// socket file left behind by a previous server must be removed before binding
+			if (File.Exists (_path))
+			{
+				if (IsUnixListenerAlive (mask))
+				{
+					_log.Warn("another CLR server already running, exiting");
+					return false;
+				}
+
+				File.Delete (_path);
+			}
+
+			_server_socket = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified);
+			_server_socket.Bind(mask);
+			_server_socket.Listen(10);
+			return true;
+		}
+
+
+		/// <summary>
+		/// Setup shared memory rings for a co-located client (replaces the socket entirely)
+		/// </summary>
+		private bool SetupSharedMemory ()
+		{
+			_log.Info("starting execution server on shared memory: " + _shm_path);
+			if (SharedMemoryStream.IsServerAlive (_shm_path))
+			{
+				_log.Warn("another CLR server already running, exiting");
+				return false;
+			}
+
+			_shm = new SharedMemoryStream (_shm_path);
+			return true;
+		}
+
+
+		/// <summary>
+		/// Determine whether some process is accepting connections on the given unix socket
+		/// </summary>
+		private static bool IsUnixListenerAlive (UnixEndPoint endpoint)
+		{
+			using (var probe = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified))
+			{
+				try
+				{
+					probe.Connect (endpoint);
+					return true;
+				}
+				catch (SocketException)
+				{
+					return false;
+				}
+			}
+		}
+
+
+		/// <summary>
+		/// Service clients on the configured transport
+		/// </summary>
+		private void Serve ()
+		{
+			if (_shm != null)
+				ServiceSharedMemory ();
+			else
+				Service ();
+		}
+
+
         /// <summary>
         /// Handle incoming clients
         /// </summary>
@@ -115,7 +201,8 @@ namespace bridge.server
                 var client_socket = _server_socket.Accept();
 
                 _log.Info("execution: received new client from: " + client_socket.RemoteEndPoint);
-				client_socket.NoDelay = true;
+				if (client_socket.AddressFamily != AddressFamily.Unix)
+					client_socket.NoDelay = true;
 				var stream = new BufferedDuplexStream(new NetworkStream(client_socket));
                 var client = new CLRBridgeServerClient (stream, client_socket.RemoteEndPoint);
 
@@ -124,11 +211,33 @@ namespace bridge.server
         }
 
 
+		/// <summary>
+		/// Handle clients attaching to the shared memory rings, one at a time
+		/// </summary>
+		private void ServiceSharedMemory ()
+		{
+			while (true)
+			{
+				_shm.Accept ();
+
+				_log.Info("execution: received new client on shared memory: " + _shm_path);
+				var client = new CLRBridgeServerClient (new BufferedDuplexStream(_shm), null);
+
+				client.Start();
+				client.Join();
+				_shm.Disconnect ();
+			}
+		}
+
+
 		#endregion
 
         // Variables
 
 		private int				_port;
+		private string			_path;
+		private string			_shm_path;
+		private SharedMemoryStream	_shm;
         private Socket			_server_socket;
 
         static Logger			_log = Logger.Get("CLR");
@@ -26,6 +26,7 @@ using bridge.common.io;
 using bridge.common.utils;
 using System.Threading;
 using bridge.server.ctrl;
+using bridge.server.data;
 using System.Net;
 using bridge.embedded;
 using System.Reflection;
@@ -81,6 +82,15 @@ namespace bridge.server
 		}
 
 
+		/// <summary>
+		/// Wait for the client to finish
+		/// </summary>
+		public void Join ()
+		{
+			_servicer.Join();
+		}
+
+
 		#region Service
 
 
@@ -140,10 +150,38 @@ namespace bridge.server
 							HandleRelease (msg as CLRReleaseMessage);
 							break;
 
+						case CLRMessage.TypeReleaseBatch:
+							HandleReleaseBatch (msg as CLRReleaseBatchMessage);
+							break;
+
 						case CLRMessage.TypeTemplateReq:
 							HandleTemplate (msg as CLRTemplateReqMessage);
 							break;
 
+						case CLRMessage.TypePrepare:
+							HandlePrepare (msg as CLRPrepareMessage);
+							break;
+
+						case CLRMessage.TypeInvoke:
+							HandleInvoke (msg as CLRInvokeMessage);
+							break;
+
+						case CLRMessage.TypeCompression:
+							HandleCompression (msg as CLRCompressionMessage);
+							break;
+
+						case CLRMessage.TypeChain:
+							HandleChain (msg as CLRChainMessage);
+							break;
+
+						case CLRMessage.TypeGetProperties:
+							HandleGetProperties (msg as CLRGetPropertiesMessage);
+							break;
+
+						case CLRMessage.TypeProject:
+							HandleProject (msg as CLRProjectMessage);
+							break;
+
 						default:
 							throw new ArgumentException ("unknown request message: " + msg);
 					}
@@ -248,6 +286,106 @@ namespace bridge.server
 		}
 		
 
+		/// <summary>
+		/// Resolves a method, replying with its handle
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandlePrepare (CLRPrepareMessage req)
+		{
+			try
+			{
+				var handle = _api.Prepare (req.ClassName, req.MethodName, req.ArgTypes);
+				CLRMessage.WriteValue (_cout, handle);
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+
+
+		/// <summary>
+		/// Calls a prepared method.
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandleInvoke (CLRInvokeMessage req)
+		{
+			try
+			{
+				var parameters = req.Parameters;
+				if (parameters.Length > 0)
+					parameters[0] = ToLocalObject (parameters[0]);
+
+				var result = _api.Invoke (req.Handle, parameters);
+				CLRMessage.WriteValue (_cout, result);
+			}
+			catch (TargetInvocationException te)
+			{
+				CLRMessage.WriteValue (_cout, te.GetBaseException());
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+		
+
+		/// <summary>
+		/// Evaluates a chain of calls and gets, each on the result of the previous, replying with the final value
+		/// (intermediate objects are not registered as proxies)
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandleChain (CLRChainMessage req)
+		{
+			try
+			{
+				bool isstatic = req.ClassName.Length > 0;
+				var obj = isstatic ? null : ToLocalObject (req.Obj);
+
+				for (int i = 0 ; i < req.Steps.Length ; i++)
+				{
+					var step = req.Steps[i];
+					if (!(isstatic && i == 0) && obj == null)
+						throw new ArgumentException ("cannot apply " + step.Name + " to null (step " + (i+1) + " of chain)");
+
+					switch (step.Kind)
+					{
+						case CLRChainMessage.StepCall:
+							obj = (isstatic && i == 0) ?
+								_api.CallStaticMethodByName (req.ClassName, step.Name, step.Parameters) :
+								_api.CallMethod (obj, step.Name, step.Parameters);
+							break;
+
+						case CLRChainMessage.StepGet:
+							obj = (isstatic && i == 0) ?
+								_api.GetStaticProperty (req.ClassName, step.Name) :
+								_api.GetProperty (obj, step.Name);
+							break;
+
+						case CLRChainMessage.StepIndex:
+							if (isstatic && i == 0)
+								throw new ArgumentException ("cannot index class " + req.ClassName);
+							obj = _api.GetIndexed (obj, Convert.ToInt32 (step.Parameters[0]));
+							break;
+
+						default:
+							throw new ArgumentException ("unknown chain step: " + step.Kind);
+					}
+				}
+
+				CLRMessage.WriteValue (_cout, obj);
+			}
+			catch (TargetInvocationException te)
+			{
+				CLRMessage.WriteValue (_cout, te.GetBaseException());
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+		
+
 		/// <summary>
 		/// Gets property on object.
 		/// </summary>
@@ -273,6 +411,59 @@ namespace bridge.server
 		}
 		
 		
+		/// <summary>
+		/// Gets several properties of an object, replying with their values as an object array
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandleGetProperties (CLRGetPropertiesMessage req)
+		{
+			try
+			{
+				// get object
+				var obj = ToLocalObject (req.Obj);
+
+				var names = req.PropertyNames;
+				var values = new object[names.Length];
+				for (int i = 0 ; i < names.Length ; i++)
+					values[i] = _api.GetProperty (obj, names[i]);
+
+				CLRMessage.WriteValue (_cout, values);
+			}
+			catch (TargetInvocationException te)
+			{
+				CLRMessage.WriteValue (_cout, te.GetBaseException());
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+		
+		
+		/// <summary>
+		/// Reads properties of each element of a collection, replying with one typed column per property
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandleProject (CLRProjectMessage req)
+		{
+			try
+			{
+				// get collection
+				var collection = ToLocalObject (req.Obj);
+				var columns = _api.Project (collection, req.PropertyNames);
+				CLRMessage.WriteValue (_cout, columns);
+			}
+			catch (TargetInvocationException te)
+			{
+				CLRMessage.WriteValue (_cout, te.GetBaseException());
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+		
+		
 		/// <summary>
 		/// Sets property on object.
 		/// </summary>
@@ -413,6 +604,35 @@ namespace bridge.server
 		}
 
 
+		/// <summary>
+		/// Sets the size from which values sent to this client are compressed
+		/// </summary>
+		/// <param name="req">Request.</param>
+		private void HandleCompression (CLRCompressionMessage req)
+		{
+			if (req.Codec != CLRCompressedMessage.CodecDeflate)
+			{
+				CLRMessage.WriteValue (_cout, new ArgumentException ("unsupported compression codec: " + req.Codec));
+				return;
+			}
+
+			// this thread serves only this client
+			CLRCompressedMessage.Threshold = Math.Max (req.Threshold, 0);
+			CLRMessage.WriteValue (_cout, null);
+		}
+
+
+		/// <summary>
+		/// Releases a batch of objects for GCing
+		/// </summary>
+		/// <param name="req">Request.</param>
+		private void HandleReleaseBatch (CLRReleaseBatchMessage req)
+		{
+			foreach (var id in req.ObjectIds)
+				CLRObjectProxy.Release (id);
+		}
+
+
 		#endregion
 
 		#region Miscellaneous
@@ -21,6 +21,8 @@
 //
 
 using System;
+using System.IO;
+using System.Text;
 using bridge.common.io;
 using System.Collections.Generic;
 using bridge.math.matrix;
@@ -93,7 +95,13 @@ namespace bridge.server
 			var msg = Create (type);
 
 			msg.Deserialize (stream);
-			return msg;
+
+			// compressed envelope: read the message it carries in its place
+			var envelope = msg as CLRCompressedMessage;
+			if (envelope != null)
+				return Read (envelope.Reader);
+			else
+				return msg;
 		}
 
 
@@ -165,6 +173,8 @@ namespace bridge.server
 					return new CLRBoolArrayMessage ();
 				case TypeByteArray:
 					return new CLRByteArrayMessage ();
+				case TypeFloat32Array:
+					return new CLRFloat32ArrayMessage ();
 				case TypeInt32Array:
 					return new CLRInt32ArrayMessage ();
 				case TypeInt64Array:
@@ -175,6 +185,8 @@ namespace bridge.server
 					return new CLRStringArrayMessage ();
 				case TypeObjectArray:
 					return new CLRObjectArrayMessage ();
+				case TypeBitArray:
+					return new CLRBitArrayMessage ();
 				
 				case TypeVector:
 					return new CLRVectorMessage ();
@@ -182,6 +194,8 @@ namespace bridge.server
 					return new CLRMatrixMessage ();
 				case TypeException:
 					return new CLRExceptionMessage ();
+				case TypeCompressed:
+					return new CLRCompressedMessage ();
 
 				case TypeCreate:
 					return new CLRCreateMessage ();
@@ -205,6 +219,20 @@ namespace bridge.server
 					return new CLRProtectMessage ();
 				case TypeRelease:
 					return new CLRReleaseMessage ();
+				case TypeReleaseBatch:
+					return new CLRReleaseBatchMessage ();
+				case TypePrepare:
+					return new CLRPrepareMessage ();
+				case TypeInvoke:
+					return new CLRInvokeMessage ();
+				case TypeCompression:
+					return new CLRCompressionMessage ();
+				case TypeChain:
+					return new CLRChainMessage ();
+				case TypeGetProperties:
+					return new CLRGetPropertiesMessage ();
+				case TypeProject:
+					return new CLRProjectMessage ();
 
 				case TypeTemplateReq:
 					return new CLRTemplateReqMessage ();
@@ -290,6 +318,10 @@ namespace bridge.server
 					msg = new CLRByteArrayMessage ((byte[])val);
 					break;
 
+				case TypeFloat32Array:
+					msg = new CLRFloat32ArrayMessage ((float[])val);
+					break;
+
 				case TypeInt32Array:
 					msg = new CLRInt32ArrayMessage ((int[])val);
 					break;
@@ -310,6 +342,13 @@ namespace bridge.server
 					msg = new CLRObjectArrayMessage ((object[])val);
 					break;
 
+				case TypeBitArray:
+					if (val is bool[])
+						msg = new CLRBitArrayMessage ((bool[])val);
+					else
+						msg = new CLRBitArrayMessage ((bool?[])val);
+					break;
+
 				case TypeVector:
 					msg = new CLRVectorMessage ((Vector<double>)val);
 					break;
@@ -326,7 +365,10 @@ namespace bridge.server
 					throw new ArgumentException ("do not know how to serialize: " + val.GetType());
 			}
 
-			msg.Serialize (cout);
+			if (CLRCompressedMessage.Threshold > 0 && CLRCompressedMessage.WidthOf (msg.MessageType) > 0)
+				CLRCompressedMessage.Write (cout, msg);
+			else
+				msg.Serialize (cout);
 		}
 
 
@@ -370,6 +412,9 @@ namespace bridge.server
 				case TypeByteArray:
 					return ((CLRByteArrayMessage)msg).Value;
 
+				case TypeFloat32Array:
+					return ((CLRFloat32ArrayMessage)msg).Value;
+
 				case TypeInt32Array:
 					return ((CLRInt32ArrayMessage)msg).Value;
 
@@ -385,6 +430,9 @@ namespace bridge.server
 				case TypeObjectArray:
 					return ((CLRObjectArrayMessage)msg).Value;
 
+				case TypeBitArray:
+					return ((CLRBitArrayMessage)msg).ToObject();
+
 				case TypeVector:
 					return ((CLRVectorMessage)msg).Value;
 
@@ -402,6 +450,215 @@ namespace bridge.server
 
 		#endregion 
 
+		#region Bulk IO
+
+
+		/// <summary>
+		/// Write an array of doubles in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="values">Values.</param>
+		/// <param name="count">Number of values to write.</param>
+		protected static void WriteDoubles (IBinaryWriter cout, double[] values, int count)
+		{
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					cout.WriteDouble (values[i]);
+				return;
+			}
+
+			var chunk = new byte[Math.Min (count * 8, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 8);
+				Buffer.BlockCopy (values, i * 8, chunk, 0, n * 8);
+				cout.Write (chunk, 0, n * 8);
+				i += n;
+			}
+		}
+
+
+		/// <summary>
+		/// Read an array of doubles in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <returns>The values.</returns>
+		/// <param name="cin">Cin.</param>
+		/// <param name="count">Number of values to read.</param>
+		protected static double[] ReadDoubles (IBinaryReader cin, int count)
+		{
+			var values = new double[count];
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					values[i] = cin.ReadDouble ();
+				return values;
+			}
+
+			var chunk = new byte[Math.Min (count * 8, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 8);
+				if (cin.Read (chunk, 0, n * 8) < n * 8)
+					throw new EndOfStreamException ("end of stream reached while reading array");
+
+				Buffer.BlockCopy (chunk, 0, values, i * 8, n * 8);
+				i += n;
+			}
+
+			return values;
+		}
+
+
+		/// <summary>
+		/// Write an array of longs in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="values">Values.</param>
+		/// <param name="count">Number of values to write.</param>
+		protected static void WriteLongs (IBinaryWriter cout, long[] values, int count)
+		{
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					cout.WriteInt64 (values[i]);
+				return;
+			}
+
+			var chunk = new byte[Math.Min (count * 8, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 8);
+				Buffer.BlockCopy (values, i * 8, chunk, 0, n * 8);
+				cout.Write (chunk, 0, n * 8);
+				i += n;
+			}
+		}
+
+
+		/// <summary>
+		/// Read an array of longs in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <returns>The values.</returns>
+		/// <param name="cin">Cin.</param>
+		/// <param name="count">Number of values to read.</param>
+		protected static long[] ReadLongs (IBinaryReader cin, int count)
+		{
+			var values = new long[count];
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					values[i] = cin.ReadInt64 ();
+				return values;
+			}
+
+			var chunk = new byte[Math.Min (count * 8, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 8);
+				if (cin.Read (chunk, 0, n * 8) < n * 8)
+					throw new EndOfStreamException ("end of stream reached while reading array");
+
+				Buffer.BlockCopy (chunk, 0, values, i * 8, n * 8);
+				i += n;
+			}
+
+			return values;
+		}
+
+
+		/// <summary>
+		/// Write an array of floats in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="values">Values.</param>
+		/// <param name="count">Number of values to write.</param>
+		protected static void WriteFloats (IBinaryWriter cout, float[] values, int count)
+		{
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					cout.WriteUInt32 (BitConverter.ToUInt32 (BitConverter.GetBytes (values[i]), 0));
+				return;
+			}
+
+			var chunk = new byte[Math.Min (count * 4, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 4);
+				Buffer.BlockCopy (values, i * 4, chunk, 0, n * 4);
+				cout.Write (chunk, 0, n * 4);
+				i += n;
+			}
+		}
+
+
+		/// <summary>
+		/// Read an array of floats in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <returns>The values.</returns>
+		/// <param name="cin">Cin.</param>
+		/// <param name="count">Number of values to read.</param>
+		protected static float[] ReadFloats (IBinaryReader cin, int count)
+		{
+			var values = new float[count];
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					values[i] = BitConverter.ToSingle (BitConverter.GetBytes (cin.ReadUInt32 ()), 0);
+				return values;
+			}
+
+			var chunk = new byte[Math.Min (count * 4, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 4);
+				if (cin.Read (chunk, 0, n * 4) < n * 4)
+					throw new EndOfStreamException ("end of stream reached while reading array");
+
+				Buffer.BlockCopy (chunk, 0, values, i * 4, n * 4);
+				i += n;
+			}
+
+			return values;
+		}
+
+
+		/// <summary>
+		/// Write a UTF-8 string, or a length of -1 for null (NA in R)
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="value">Value.</param>
+		protected static void WriteStringOrNull (IBinaryWriter cout, string value)
+		{
+			if (value != null)
+				cout.WriteString (value, Encoding.UTF8);
+			else
+				cout.WriteInt32 (NullLength);
+		}
+
+
+		/// <summary>
+		/// Read a UTF-8 string, null if sent with a length of -1
+		/// </summary>
+		/// <returns>The string.</returns>
+		/// <param name="cin">Cin.</param>
+		protected static string ReadStringOrNull (IBinaryReader cin)
+		{
+			var len = cin.ReadInt32();
+			if (len == NullLength)
+				return null;
+
+			var data = new byte[len];
+			if (cin.Read (data, 0, len) < len)
+				throw new EndOfStreamException ("end of stream reached while reading string");
+
+			return Encoding.UTF8.GetString (data);
+		}
+
+
+		#endregion
+
 		#region Message Types
 
 		public const ushort			Magic						= 0xd00d;
@@ -418,14 +675,17 @@ namespace bridge.server
 		public const byte			TypeVector					= 21;
 		public const byte			TypeMatrix					= 22;
 		public const byte			TypeException				= 23;
+		public const byte			TypeCompressed				= 24;
 
 		public const byte			TypeBoolArray				= 101;
 		public const byte			TypeByteArray				= 102;
+		public const byte			TypeFloat32Array			= 103;
 		public const byte			TypeInt32Array				= 105;
 		public const byte			TypeInt64Array				= 106;
 		public const byte			TypeReal64Array				= 107;
 		public const byte			TypeStringArray				= 108;
 		public const byte			TypeObjectArray				= 109;
+		public const byte			TypeBitArray				= 110;
 
 		public const byte			TypeCreate					= 201;
 		public const byte			TypeCallStaticMethod		= 202;
@@ -441,6 +701,13 @@ namespace bridge.server
 
 		public const byte			TypeTemplateReq				= 212;
 		public const byte			TypeTemplateReply			= 213;
+		public const byte			TypeReleaseBatch			= 214;
+		public const byte			TypePrepare					= 215;
+		public const byte			TypeInvoke					= 216;
+		public const byte			TypeCompression				= 217;
+		public const byte			TypeChain					= 218;
+		public const byte			TypeGetProperties			= 219;
+		public const byte			TypeProject					= 220;
 
 		#endregion
 
@@ -459,11 +726,12 @@ namespace bridge.server
 			_typemap[typeof(string)] = TypeString;
 			_typemap[typeof(object)] = TypeObject;
 
-			_typemap[typeof(bool[])] = TypeBoolArray;
+			_typemap[typeof(bool[])] = TypeBitArray;
+			_typemap[typeof(bool?[])] = TypeBitArray;
 			_typemap[typeof(byte[])] = TypeByteArray;
 			_typemap[typeof(int[])] = TypeInt32Array;
 			_typemap[typeof(long[])] = TypeInt64Array;
-			_typemap[typeof(float[])] = TypeReal64Array;
+			_typemap[typeof(float[])] = TypeFloat32Array;
 			_typemap[typeof(double[])] = TypeReal64Array;
 			_typemap[typeof(string[])] = TypeStringArray;
 			_typemap[typeof(object[])] = TypeObjectArray;
@@ -480,6 +748,9 @@ namespace bridge.server
 
 		// Variables
 
+		protected const int				BulkChunkSize = 64 * 1024;
+		protected const int				NullLength = -1;
+
 		protected byte					_type;
 		static Dictionary<Type,byte>	_typemap = new Dictionary<Type,byte>();
 	}
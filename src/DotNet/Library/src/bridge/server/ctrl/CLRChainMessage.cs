@@ -0,0 +1,156 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using bridge.common.io;
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR Chain message: a sequence of method calls and property or indexed gets, each applied to the result
+	/// of the previous, evaluated in one request with only the final value returned
+	/// </summary>
+	public class CLRChainMessage : CLRMessage
+	{
+		// step kinds
+		public const byte StepCall = 0;
+		public const byte StepGet = 1;
+		public const byte StepIndex = 2;
+
+		/// <summary>
+		/// A step of the chain
+		/// </summary>
+		public class Step
+		{
+			public Step (byte kind, string name, params object[] args)
+			{
+				Kind = kind;
+				Name = name;
+				Parameters = args;
+			}
+
+			public byte Kind
+				{ get; private set; }
+
+			public string Name
+				{ get; private set; }
+
+			public object[] Parameters
+				{ get; private set; }
+		}
+
+
+		public CLRChainMessage ()
+			: base (TypeChain)
+		{
+		}
+
+		public CLRChainMessage (object obj, params Step[] steps)
+			: base (TypeChain)
+		{
+			ClassName = "";
+			Obj = obj;
+			Steps = steps;
+		}
+
+		public CLRChainMessage (string classname, params Step[] steps)
+			: base (TypeChain)
+		{
+			ClassName = classname;
+			Steps = steps;
+		}
+
+
+		// Properties
+
+		/// <summary>
+		/// Class on which the first step is a static call or get (empty if starting from an object)
+		/// </summary>
+		public string ClassName
+			{ get; private set; }
+
+		public object Obj
+			{ get; private set; }
+
+		public Step[] Steps
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+
+			// starting class or object
+			cout.WriteString (ClassName);
+			CLRMessage.SerializeValue (cout, Obj);
+
+			// steps
+			cout.WriteUInt16 ((ushort)Steps.Length);
+			foreach (var step in Steps)
+			{
+				cout.WriteByte (step.Kind);
+				cout.WriteString (step.Name);
+
+				cout.WriteUInt16 ((ushort)step.Parameters.Length);
+				for (int i = 0 ; i < step.Parameters.Length ; i++)
+					CLRMessage.SerializeValue (cout, step.Parameters[i]);
+			}
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			// starting class or object
+			ClassName = cin.ReadString();
+			Obj = CLRMessage.DeserializeValue (cin);
+
+			// steps
+			var len = (int)cin.ReadUInt16 ();
+			Steps = new Step[len];
+
+			for (int i = 0 ; i < len ; i++)
+			{
+				var kind = (byte)cin.ReadByte ();
+				var name = cin.ReadString ();
+
+				var argc = (int)cin.ReadUInt16 ();
+				var args = new object[argc];
+				for (int j = 0 ; j < argc ; j++)
+					args[j] = CLRMessage.DeserializeValue (cin);
+
+				Steps[i] = new Step (kind, name, args);
+			}
+		}
+
+	}
+}
@@ -0,0 +1,81 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using bridge.common.io;
+using bridge.server.data;
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR compression message: compress values of at least the given size in either direction (0 to disable).
+	/// </summary>
+	public class CLRCompressionMessage : CLRMessage
+	{
+		public CLRCompressionMessage ()
+			: base (TypeCompression)
+		{
+		}
+
+		public CLRCompressionMessage (int threshold, byte codec = CLRCompressedMessage.CodecDeflate)
+			: base (TypeCompression)
+		{
+			Threshold = threshold;
+			Codec = codec;
+		}
+
+
+		// Properties
+
+		public int Threshold
+			{ get; private set; }
+
+		public byte Codec
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+			cout.WriteInt32 (Threshold);
+			cout.WriteByte (Codec);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			Threshold = cin.ReadInt32();
+			Codec = (byte)cin.ReadByte();
+		}
+	}
+}
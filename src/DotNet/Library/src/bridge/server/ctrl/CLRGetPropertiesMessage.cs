@@ -0,0 +1,90 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using bridge.common.io;
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR GetProperties message: several properties of an object, read in one request.
+	/// </summary>
+	public class CLRGetPropertiesMessage : CLRMessage
+	{
+		public CLRGetPropertiesMessage ()
+			: base (TypeGetProperties)
+		{
+		}
+
+		public CLRGetPropertiesMessage (object obj, params string[] properties)
+			: base (TypeGetProperties)
+		{
+			Obj = obj;
+			PropertyNames = properties;
+		}
+
+
+		// Properties
+
+		public object Obj
+			{ get; private set; }
+
+		public string[] PropertyNames
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+
+			// object & property names
+			cout.WriteInt32 (CLRObjectProxy.ProxyIdFor (Obj));
+			cout.WriteUInt16 ((ushort)PropertyNames.Length);
+			foreach (var name in PropertyNames)
+				cout.WriteString (name);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			// object & property names
+			Obj = CLRObjectProxy.Find (cin.ReadInt32(), proxyok: true);
+			var len = (int)cin.ReadUInt16 ();
+			PropertyNames = new string[len];
+			for (int i = 0 ; i < len ; i++)
+				PropertyNames[i] = cin.ReadString();
+		}
+
+	}
+}
+
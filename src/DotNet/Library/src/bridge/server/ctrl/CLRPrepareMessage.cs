@@ -0,0 +1,103 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using bridge.common.io;
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR Prepare message: resolves a method once, replying with a handle for use with CLRInvokeMessage
+	/// </summary>
+	public class CLRPrepareMessage : CLRMessage
+	{
+		public CLRPrepareMessage ()
+			: base (TypePrepare)
+		{
+		}
+
+		public CLRPrepareMessage (string classname, string method, string[] argtypes)
+			: base (TypePrepare)
+		{
+			ClassName = classname;
+			MethodName = method;
+			ArgTypes = argtypes;
+		}
+
+
+		// Properties
+
+		public string ClassName
+			{ get; private set; }
+
+		public string MethodName
+			{ get; private set; }
+
+		public string[] ArgTypes
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+
+			// class & method names
+			cout.WriteString (ClassName);
+			cout.WriteString (MethodName);
+
+			// argument types (-1 if not given)
+			cout.WriteInt32 (ArgTypes != null ? ArgTypes.Length : -1);
+			for (int i = 0 ; ArgTypes != null && i < ArgTypes.Length ; i++)
+				cout.WriteString (ArgTypes[i]);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			// class & method names
+			ClassName = cin.ReadString();
+			MethodName = cin.ReadString();
+
+			// argument types
+			var len = cin.ReadInt32 ();
+			if (len < 0)
+				return;
+
+			ArgTypes = new string[len];
+			for (int i = 0 ; i < len ; i++)
+				ArgTypes[i] = cin.ReadString();
+		}
+
+	}
+}
+
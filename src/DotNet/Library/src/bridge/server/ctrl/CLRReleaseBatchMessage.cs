@@ -0,0 +1,82 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using bridge.common.io;
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR Release message for a batch of objects (sent by clients that coalesce releases).
+	/// </summary>
+	public class CLRReleaseBatchMessage : CLRMessage
+	{
+		public CLRReleaseBatchMessage ()
+			: base (TypeReleaseBatch)
+		{
+		}
+
+		public CLRReleaseBatchMessage (int[] objectIds)
+			: base (TypeReleaseBatch)
+		{
+			ObjectIds = objectIds;
+		}
+
+
+		// Properties
+
+		public int[] ObjectIds
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+
+			cout.WriteInt32 (ObjectIds.Length);
+			for (int i = 0 ; i < ObjectIds.Length ; i++)
+				cout.WriteInt32 (ObjectIds[i]);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			var len = cin.ReadInt32();
+			ObjectIds = new int[len];
+
+			for (int i = 0 ; i < len ; i++)
+				ObjectIds[i] = cin.ReadInt32();
+		}
+	}
+}
+
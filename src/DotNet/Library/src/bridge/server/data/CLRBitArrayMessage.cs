@@ -0,0 +1,190 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using System.IO;
+using bridge.common.io;
+
+
+namespace bridge.server.data
+{
+	/// <summary>
+	/// CLR packed logical array message.  Values are sent as a bitset (8 per byte, lsb first), followed
+	/// by a bitset marking NA entries when any are present.  Decodes to bool[], or bool?[] when NAs are present.
+	/// </summary>
+	public class CLRBitArrayMessage : CLRMessage
+	{
+		public CLRBitArrayMessage ()
+			: base (TypeBitArray)
+		{
+		}
+
+		public CLRBitArrayMessage (bool[] value, int len = -1)
+			: base (TypeBitArray)
+		{
+			Value = value;
+			Length = len >= 0 ? len : Value.Length;
+		}
+
+		public CLRBitArrayMessage (bool?[] value, int len = -1)
+			: base (TypeBitArray)
+		{
+			Nullable = value;
+			Length = len >= 0 ? len : Nullable.Length;
+		}
+
+
+		// Properties
+
+		public bool[] Value
+			{ get; private set; }
+
+		public bool?[] Nullable
+			{ get; private set; }
+
+		public int Length
+			{ get; set; }
+
+
+		// Functions
+
+		/// <summary>
+		/// Get the array value, as bool?[] if NAs were received, otherwise bool[]
+		/// </summary>
+		public object ToObject ()
+		{
+			if (Nullable != null)
+				return Nullable;
+			else
+				return Value;
+		}
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+			cout.WriteInt32 (Length);
+
+			var nbytes = (Length + 7) / 8;
+			var bits = new byte[nbytes];
+			var na = Nullable != null ? new byte[nbytes] : null;
+			var hasNA = Nullable != null ? Pack (Nullable, Length, bits, na) : Pack (Value, Length, bits);
+
+			cout.WriteByte (hasNA ? FlagNA : (byte)0);
+			cout.Write (bits, 0, nbytes);
+			if (hasNA)
+				cout.Write (na, 0, nbytes);
+		}
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			Length = cin.ReadInt32();
+			var flags = cin.ReadByte();
+
+			var nbytes = (Length + 7) / 8;
+			var bits = ReadBits (cin, nbytes);
+
+			if ((flags & FlagNA) != 0)
+			{
+				var na = ReadBits (cin, nbytes);
+				Nullable = new bool?[Length];
+				for (int i = 0 ; i < Length ; i++)
+				{
+					if ((na[i >> 3] & (1 << (i & 7))) == 0)
+						Nullable[i] = (bits[i >> 3] & (1 << (i & 7))) != 0;
+				}
+			}
+			else
+			{
+				Value = new bool[Length];
+				for (int i = 0, b = 0 ; i < Length ; i += 8, b++)
+				{
+					int v = bits[b];
+					int n = Math.Min (8, Length - i);
+					for (int k = 0 ; k < n ; k++)
+						Value[i + k] = ((v >> k) & 1) != 0;
+				}
+			}
+		}
+
+
+		// Implementation
+
+		private static byte[] ReadBits (IBinaryReader cin, int nbytes)
+		{
+			var bits = new byte[nbytes];
+			if (cin.Read (bits, 0, nbytes) < nbytes)
+				throw new EndOfStreamException ("end of stream reached while reading array");
+			return bits;
+		}
+
+		private static bool Pack (bool[] values, int len, byte[] bits)
+		{
+			for (int i = 0, b = 0 ; i < len ; i += 8, b++)
+			{
+				int v = 0;
+				int n = Math.Min (8, len - i);
+				for (int k = 0 ; k < n ; k++)
+				{
+					if (values[i + k])
+						v |= 1 << k;
+				}
+				bits[b] = (byte)v;
+			}
+
+			return false;
+		}
+
+		private static bool Pack (bool?[] values, int len, byte[] bits, byte[] na)
+		{
+			var hasNA = false;
+			for (int i = 0 ; i < len ; i++)
+			{
+				var mask = (byte)(1 << (i & 7));
+				if (!values[i].HasValue)
+				{
+					na[i >> 3] |= mask;
+					hasNA = true;
+				}
+				else if (values[i].Value)
+					bits[i >> 3] |= mask;
+			}
+
+			return hasNA;
+		}
+
+
+		// Variables
+
+		public const byte		FlagNA = 1;
+	}
+}
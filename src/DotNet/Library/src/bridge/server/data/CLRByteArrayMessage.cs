@@ -21,6 +21,7 @@
 //
 
 using System;
+using System.IO;
 using bridge.common.io;
 
 
@@ -63,9 +64,7 @@ namespace bridge.server.data
 		{
 			base.Serialize (cout);
 			cout.WriteInt32 (Length);
-
-			for (int i = 0 ; i < Length ; i++)
-				cout.WriteByte (Value[i]);
+			cout.Write (Value, 0, Length);
 		}
 		
 		/// <summary>
@@ -76,9 +75,9 @@ namespace bridge.server.data
 		{
 			Length = cin.ReadInt32();
 			Value = new byte[Length];
-			 
-			for (int i = 0 ; i < Length ; i++)
-				Value[i] = (byte)cin.ReadByte();
+
+			if (cin.Read (Value, 0, Length) < Length)
+				throw new EndOfStreamException ("end of stream reached while reading array");
 		}
 
 	}
@@ -0,0 +1,251 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using System.IO;
+using System.IO.Compression;
+using System.Threading.Tasks;
+using bridge.common.io;
+
+
+namespace bridge.server.data
+{
+	/// <summary>
+	/// CLR compressed value envelope, wrapping the complete message for an array or matrix value:
+	/// <para>
+	/// codec (byte), element width (byte), uncompressed length (int32), chunk size (int32), followed by
+	/// the compressed length (int32) and raw deflate data for each chunk.
+	/// </para>
+	/// The data is byte-shuffled by element width before compression (grouping the 1st byte of every element,
+	/// then the 2nd, ...).  Chunks are compressed independently, in parallel for large values.
+	/// </summary>
+	public class CLRCompressedMessage : CLRMessage
+	{
+		public CLRCompressedMessage ()
+			: base (TypeCompressed)
+		{
+		}
+
+		public CLRCompressedMessage (byte[] data, int len, int width)
+			: base (TypeCompressed)
+		{
+			Data = data;
+			Length = len;
+			Width = width;
+		}
+
+
+		// Properties
+
+		/// <summary>
+		/// Size from which values written by the current thread (serving a client) are compressed, or 0 if not compressing
+		/// </summary>
+		public static int Threshold
+			{ get { return _threshold; } set { _threshold = value; } }
+
+		public byte[] Data
+			{ get; private set; }
+
+		public int Length
+			{ get; private set; }
+
+		public int Width
+			{ get; private set; }
+
+		/// <summary>
+		/// Reader over the uncompressed message
+		/// </summary>
+		public IBinaryReader Reader
+			{ get { return EndianStreams.ReaderFor (new MemoryStream (Data, 0, Length), EndianStreams.Endian.Little); } }
+
+
+		// Functions
+
+		/// <summary>
+		/// Element width to shuffle by for a given message type, or 0 if the type is not compressed
+		/// </summary>
+		/// <param name="type">Message type.</param>
+		public static int WidthOf (byte type)
+		{
+			switch (type)
+			{
+				case TypeVector:
+				case TypeMatrix:
+				case TypeReal64Array:
+				case TypeInt64Array:
+					return 8;
+				case TypeInt32Array:
+				case TypeFloat32Array:
+					return 4;
+				case TypeBoolArray:
+				case TypeBitArray:
+				case TypeByteArray:
+				case TypeStringArray:
+					return 1;
+				default:
+					return 0;
+			}
+		}
+
+
+		/// <summary>
+		/// Write value message, in a compressed envelope if at least the threshold size
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="msg">Value message.</param>
+		public static void Write (IBinaryWriter cout, CLRMessage msg)
+		{
+			var buffer = new MemoryStream ();
+			var writer = EndianStreams.WriterFor (buffer, EndianStreams.Endian.Little);
+			msg.Serialize (writer);
+			writer.Flush ();
+
+			var len = (int)buffer.Length;
+			if (len < Threshold)
+				cout.Write (buffer.GetBuffer(), 0, len);
+			else
+				new CLRCompressedMessage (buffer.GetBuffer(), len, WidthOf (msg.MessageType)).Serialize (cout);
+		}
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			var data = Width > 1 ? Shuffle (Data, Length, Width) : Data;
+			var chunks = new byte[(Length + ChunkSize - 1) / ChunkSize][];
+			Parallel.For (0, chunks.Length, i => 
+				chunks[i] = Deflate (data, i * ChunkSize, Math.Min (ChunkSize, Length - i * ChunkSize)));
+
+			base.Serialize (cout);
+			cout.WriteByte (CodecDeflate);
+			cout.WriteByte ((byte)Width);
+			cout.WriteInt32 (Length);
+			cout.WriteInt32 (ChunkSize);
+			foreach (var chunk in chunks)
+			{
+				cout.WriteInt32 (chunk.Length);
+				cout.Write (chunk, 0, chunk.Length);
+			}
+		}
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			var codec = (byte)cin.ReadByte();
+			if (codec != CodecDeflate)
+				throw new ArgumentException ("unknown compression codec: " + codec);
+
+			Width = (byte)cin.ReadByte();
+			Length = cin.ReadInt32();
+			var chunksize = cin.ReadInt32();
+			if (Length < 0 || chunksize <= 0)
+				throw new ArgumentException ("bad compressed value envelope");
+
+			var chunks = new byte[(int)(((long)Length + chunksize - 1) / chunksize)][];
+			for (int i = 0 ; i < chunks.Length ; i++)
+			{
+				chunks[i] = new byte[cin.ReadInt32()];
+				if (cin.Read (chunks[i], 0, chunks[i].Length) < chunks[i].Length)
+					throw new EndOfStreamException ("end of stream reached while reading compressed value");
+			}
+
+			var data = new byte[Length];
+			Parallel.For (0, chunks.Length, i => 
+				Inflate (chunks[i], data, i * chunksize, Math.Min (chunksize, Length - i * chunksize)));
+
+			Data = Width > 1 ? Unshuffle (data, Length, Width) : data;
+		}
+
+
+		// Implementation
+
+		private static byte[] Deflate (byte[] data, int offset, int count)
+		{
+			using (var output = new MemoryStream ())
+			{
+				using (var deflater = new DeflateStream (output, CompressionLevel.Fastest, true))
+					deflater.Write (data, offset, count);
+				return output.ToArray();
+			}
+		}
+
+		private static void Inflate (byte[] chunk, byte[] data, int offset, int count)
+		{
+			using (var inflater = new DeflateStream (new MemoryStream (chunk), CompressionMode.Decompress))
+			{
+				var read = 0;
+				while (read < count)
+				{
+					var n = inflater.Read (data, offset + read, count - read);
+					if (n == 0)
+						throw new EndOfStreamException ("compressed value is truncated");
+					read += n;
+				}
+			}
+		}
+
+		private static byte[] Shuffle (byte[] src, int len, int width)
+		{
+			var dst = new byte[len];
+			var n = len / width;
+			for (int j = 0 ; j < width ; j++)
+			{
+				for (int i = 0 ; i < n ; i++)
+					dst[j * n + i] = src[i * width + j];
+			}
+
+			Buffer.BlockCopy (src, n * width, dst, n * width, len - n * width);
+			return dst;
+		}
+
+		private static byte[] Unshuffle (byte[] src, int len, int width)
+		{
+			var dst = new byte[len];
+			var n = len / width;
+			for (int j = 0 ; j < width ; j++)
+			{
+				for (int i = 0 ; i < n ; i++)
+					dst[i * width + j] = src[j * n + i];
+			}
+
+			Buffer.BlockCopy (src, n * width, dst, n * width, len - n * width);
+			return dst;
+		}
+
+
+		// Variables
+
+		public const byte		CodecDeflate = 1;
+		public const int		ChunkSize = 1 << 20;
+
+		[ThreadStatic]
+		private static int		_threshold;
+	}
+}
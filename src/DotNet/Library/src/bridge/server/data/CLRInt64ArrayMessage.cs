@@ -63,9 +63,7 @@ namespace bridge.server.data
 		{
 			base.Serialize (cout);
 			cout.WriteInt32 (Length);
-
-			for (int i = 0 ; i < Length ; i++)
-				cout.WriteInt64 (Value[i]);
+			WriteLongs (cout, Value, Length);
 		}
 		
 		/// <summary>
@@ -75,10 +73,7 @@ namespace bridge.server.data
 		public override void Deserialize (IBinaryReader cin)
 		{
 			Length = cin.ReadInt32();
-			Value = new long[Length];
-			 
-			for (int i = 0 ; i < Length ; i++)
-				Value[i] = cin.ReadInt64();
+			Value = ReadLongs (cin, Length);
 		}
 
 	}
@@ -23,6 +23,7 @@
 using System;
 using bridge.common.io;
 using MathNet.Numerics.LinearAlgebra;
+using MathNet.Numerics.LinearAlgebra.Double;
 using bridge.math.matrix;
 using System.Text;
 
@@ -70,7 +71,7 @@ namespace bridge.server.data
 				var indices = rindices.NameList;
 				cout.WriteInt32 (indices.Length);
 				for (int i = 0 ; i < indices.Length ; i++)
-					cout.WriteString (indices[i], Encoding.ASCII);
+					WriteStringOrNull (cout, indices[i]);
 			} else
 				cout.WriteInt32 (0);
 			
@@ -79,13 +80,21 @@ namespace bridge.server.data
 				var indices = cindices.NameList;
 				cout.WriteInt32 (indices.Length);
 				for (int i = 0 ; i < indices.Length ; i++)
-					cout.WriteString (indices[i], Encoding.ASCII);
+					WriteStringOrNull (cout, indices[i]);
 			} else
 				cout.WriteInt32 (0);
 
 			cout.WriteInt32 (Value.RowCount);
 			cout.WriteInt32 (Value.ColumnCount);
 
+			// dense storage is column-major, matching the wire format, so can be sent as a block
+			var dense = Value as DenseMatrix;
+			if (dense != null)
+			{
+				WriteDoubles (cout, dense.Values, Value.RowCount * Value.ColumnCount);
+				return;
+			}
+
 			for (int ci = 0 ; ci < Value.ColumnCount ; ci++)
 			{
 				for (int ri = 0 ; ri < Value.RowCount ; ri++)
@@ -111,7 +120,7 @@ namespace bridge.server.data
 			{
 				rindex = new IndexByName<string> ();
 				for (int i = 0 ; i < ridxlen ; i++)
-					rindex.Add (cin.ReadString());
+					rindex.Add (ReadStringOrNull (cin));
 			}
 			
 			var cidxlen = cin.ReadInt32();
@@ -119,20 +128,14 @@ namespace bridge.server.data
 			{
 				cindex = new IndexByName<string> ();
 				for (int i = 0 ; i < cidxlen ; i++)
-					cindex.Add (cin.ReadString());
+					cindex.Add (ReadStringOrNull (cin));
 			}
 
 			var rows = cin.ReadInt32();
 			var cols = cin.ReadInt32();
-			Value = new IndexedMatrix (rows, cols, rindex, cindex);
 
-			for (int ci = 0 ; ci < Value.ColumnCount ; ci++)
-			{
-				for (int ri = 0 ; ri < Value.RowCount ; ri++)
-				{
-					Value[ri,ci] = cin.ReadDouble();
-				}
-			}
+			var data = ReadDoubles (cin, rows * cols);
+			Value = new IndexedMatrix (data, rows, cols, rindex, cindex);
 		}
 	}
 }
@@ -28,7 +28,7 @@ using System.Text;
 namespace bridge.server.data
 {
 	/// <summary>
-	/// CLR string array message.
+	/// CLR string array message (a null element, NA in R, is sent with length -1)
 	/// </summary>
 	public class CLRStringArrayMessage : CLRMessage
 	{
@@ -66,7 +66,7 @@ namespace bridge.server.data
 			cout.WriteInt32 (Length);
 
 			for (int i = 0 ; i < Length ; i++)
-				cout.WriteString (Value[i], Encoding.ASCII);
+				WriteStringOrNull (cout, Value[i]);
 		}
 		
 		/// <summary>
@@ -79,7 +79,7 @@ namespace bridge.server.data
 			Value = new string[Length];
 			 
 			for (int i = 0 ; i < Length ; i++)
-				Value[i] = cin.ReadString();
+				Value[i] = ReadStringOrNull (cin);
 		}
 
 	}
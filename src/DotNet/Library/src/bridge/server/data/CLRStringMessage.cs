@@ -59,7 +59,7 @@ namespace bridge.server.data
 		public override void Serialize (IBinaryWriter cout)
 		{
 			base.Serialize (cout);
-			cout.WriteString (Value, Encoding.ASCII);
+			cout.WriteString (Value, Encoding.UTF8);
 		}
 		
 		/// <summary>
@@ -68,7 +68,7 @@ namespace bridge.server.data
 		/// <param name="cin">Cin.</param>
 		public override void Deserialize (IBinaryReader cin)
 		{
-			Value = cin.ReadString();
+			Value = cin.ReadString(Encoding.UTF8);
 		}
 
 	}
@@ -23,6 +23,7 @@
 using System;
 using bridge.common.io;
 using MathNet.Numerics.LinearAlgebra;
+using MathNet.Numerics.LinearAlgebra.Double;
 using bridge.math.matrix;
 using System.Text;
 
@@ -68,11 +69,19 @@ namespace bridge.server.data
 				var namelist = indices.NameList;
 				cout.WriteInt32 (namelist.Length);
 				for (int i = 0 ; i < namelist.Length ; i++)
-					cout.WriteString (namelist[i], Encoding.ASCII);
+					WriteStringOrNull (cout, namelist[i]);
 			} else
 				cout.WriteInt32 (0);
 
 			cout.WriteInt32 (Value.Count);
+
+			var dense = Value as DenseVector;
+			if (dense != null)
+			{
+				WriteDoubles (cout, dense.Values, Value.Count);
+				return;
+			}
+
 			for (int i = 0 ; i < Value.Count ; i++)
 				cout.WriteDouble (Value[i]);
 		}
@@ -91,14 +100,11 @@ namespace bridge.server.data
 			{
 				rindex = new IndexByName<string> ();
 				for (int i = 0 ; i < ridxlen ; i++)
-					rindex.Add (cin.ReadString());
+					rindex.Add (ReadStringOrNull (cin));
 			}
 
 			var count = cin.ReadInt32();
-			Value = new IndexedVector (count, rindex);
-
-			for (int i = 0 ; i < count ; i++)
-				Value[i] = cin.ReadDouble();
+			Value = new IndexedVector (ReadDoubles (cin, count), rindex);
 		}
 	}
 }
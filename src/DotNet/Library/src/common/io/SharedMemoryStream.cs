@@ -0,0 +1,353 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using System.Diagnostics;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Runtime.InteropServices;
+using System.Threading;
+
+
+namespace bridge.common.io
+{
+	/// <summary>
+	/// Server end of a shared memory transport, consisting of a pair of single-producer / single-consumer
+	/// ring buffers in a memory mapped file.  The layout (all little-endian) is:
+	/// <list type="bullet">
+	/// <item>[0,64): magic, version, ring capacity, connection state, server pid, client pid (int32 each)</item>
+	/// <item>[64,320): request head, request tail, reply head, reply tail (int64 each, one per cache line)</item>
+	/// <item>[4096, 4096 + capacity): request ring (client -> server)</item>
+	/// <item>[4096 + capacity, 4096 + 2*capacity): reply ring (server -> client)</item>
+	/// </list>
+	/// Head and tail are monotonically increasing byte counts, each written only by its owning side.  There is
+	/// no portable futex or eventfd on the CLR, so waiting spins, then yields, then sleeps.
+	/// </summary>
+	public unsafe class SharedMemoryStream : Stream
+	{
+		public SharedMemoryStream (string path, int capacity = DefaultCapacity)
+		{
+			if (capacity <= 0 || (capacity & (capacity - 1)) != 0)
+				throw new ArgumentException ("shared memory ring capacity must be a power of 2: " + capacity);
+
+			Path = path;
+			_capacity = capacity;
+			_mask = capacity - 1;
+
+			_file = MemoryMappedFile.CreateFromFile (path, FileMode.Create, null, HeaderSize + 2L * capacity);
+			_view = _file.CreateViewAccessor ();
+
+			byte* ptr = null;
+			_view.SafeMemoryMappedViewHandle.AcquirePointer (ref ptr);
+			_base = ptr + _view.PointerOffset;
+
+			*(int*)(_base + OffVersion) = Version;
+			*(int*)(_base + OffCapacity) = capacity;
+			*(int*)(_base + OffServerPid) = Process.GetCurrentProcess().Id;
+			Volatile.Write (ref *(int*)(_base + OffState), StateIdle);
+			Volatile.Write (ref *(int*)(_base + OffMagic), Magic);
+		}
+
+
+		// Constants
+
+		public const int			Magic				= 0x4d485344;
+		public const int			Version				= 1;
+		public const int			HeaderSize			= 4096;
+		public const int			DefaultCapacity		= 4 << 20;
+
+		public const int			StateIdle			= 0;
+		public const int			StateConnected		= 1;
+		public const int			StateClosed			= 2;
+		public const int			StateConnecting		= 3;
+
+
+		// Properties
+
+		public string Path
+			{ get; private set; }
+
+		public override bool CanRead
+			{ get { return true; } }
+
+		public override bool CanWrite
+			{ get { return true; } }
+
+		public override bool CanSeek
+			{ get { return false; } }
+
+		public override long Length
+			{ get { throw new ArgumentException ("cannot support seeking on shared memory stream"); } }
+
+		public override long Position
+		{ 
+			get { throw new ArgumentException ("cannot support seeking on shared memory stream"); } 
+			set { throw new ArgumentException ("cannot support seeking on shared memory stream"); } 
+		}
+
+
+		// Functions
+
+
+		/// <summary>
+		/// Determine whether a live server owns the shared memory file at the given path
+		/// </summary>
+		/// <param name="path">Path.</param>
+		public static bool IsServerAlive (string path)
+		{
+			if (!File.Exists (path))
+				return false;
+
+			try
+			{
+				using (var cin = new BinaryReader (new FileStream (path, FileMode.Open, FileAccess.Read, FileShare.ReadWrite)))
+				{
+					if (cin.ReadInt32 () != Magic)
+						return false;
+
+					cin.BaseStream.Seek (OffServerPid, SeekOrigin.Begin);
+					return IsProcessAlive (cin.ReadInt32 ());
+				}
+			}
+			catch (IOException)
+			{
+				return false;
+			}
+		}
+
+
+		/// <summary>
+		/// Wait for a client to attach to the rings
+		/// </summary>
+		public void Accept ()
+		{
+			while (Volatile.Read (ref *(int*)(_base + OffState)) != StateConnected)
+				Thread.Sleep (1);
+		}
+
+
+		/// <summary>
+		/// Make the rings available to the next client
+		/// </summary>
+		public void Disconnect ()
+		{
+			Volatile.Write (ref *(int*)(_base + OffState), StateIdle);
+		}
+
+
+		/// <summary>
+		/// Read available bytes from the request ring, waiting for at least 1 byte
+		/// </summary>
+		public override int Read (byte[] buffer, int offset, int count)
+		{
+			var phead = (long*)(_base + OffRequestHead);
+			var ptail = (long*)(_base + OffRequestTail);
+
+			long tail = *ptail;
+			long head = Volatile.Read (ref *phead);
+			for (int spins = 0 ; head == tail ; spins++)
+			{
+				if (!Pause (spins))
+					return 0;
+
+				head = Volatile.Read (ref *phead);
+			}
+
+			var n = (int)Math.Min (count, head - tail);
+			CopyFrom (_base + HeaderSize, tail, buffer, offset, n);
+
+			Volatile.Write (ref *ptail, tail + n);
+			return n;
+		}
+
+
+		/// <summary>
+		/// Reads a byte.
+		/// </summary>
+		public override int ReadByte ()
+		{
+			return Read (_byte, 0, 1) == 1 ? _byte[0] : -1;
+		}
+
+
+		/// <summary>
+		/// Write the buffer to the reply ring, waiting for space as needed
+		/// </summary>
+		public override void Write (byte[] buffer, int offset, int count)
+		{
+			var phead = (long*)(_base + OffReplyHead);
+			var ptail = (long*)(_base + OffReplyTail);
+
+			while (count > 0)
+			{
+				long head = *phead;
+				long free = _capacity - (head - Volatile.Read (ref *ptail));
+				for (int spins = 0 ; free == 0 ; spins++)
+				{
+					if (!Pause (spins))
+						throw new IOException ("shared memory client disconnected: " + Path);
+
+					free = _capacity - (head - Volatile.Read (ref *ptail));
+				}
+
+				var n = (int)Math.Min (count, free);
+				CopyTo (buffer, offset, _base + HeaderSize + _capacity, head, n);
+
+				Volatile.Write (ref *phead, head + n);
+				offset += n;
+				count -= n;
+			}
+		}
+
+
+		/// <summary>
+		/// Flush (writes are visible to the client as soon as they are made)
+		/// </summary>
+		public override void Flush ()
+		{
+		}
+
+
+		/// <summary>
+		/// Close the stream, removing the mapping
+		/// </summary>
+		public override void Close ()
+		{
+			if (_base == null)
+				return;
+
+			_view.SafeMemoryMappedViewHandle.ReleasePointer ();
+			_view.Dispose ();
+			_file.Dispose ();
+			_base = null;
+
+			File.Delete (Path);
+		}
+
+
+		public override long Seek (long offset, SeekOrigin origin)
+		{
+			throw new ArgumentException ("cannot support seeking on shared memory stream");
+		}
+
+		public override void SetLength (long value)
+		{
+			throw new ArgumentException ("cannot support seeking on shared memory stream");
+		}
+
+
+		#region Implementation
+
+
+		/// <summary>
+		/// Back off while waiting on the client, returning false if the client has gone away
+		/// </summary>
+		private bool Pause (int spins)
+		{
+			if (Volatile.Read (ref *(int*)(_base + OffState)) != StateConnected)
+				return false;
+
+			if (spins < SpinLimit)
+				Thread.SpinWait (20);
+			else if (spins < YieldLimit)
+				Thread.Yield ();
+			else
+			{
+				Thread.Sleep (1);
+				if ((spins - YieldLimit) % 1000 == 999 && !IsProcessAlive (*(int*)(_base + OffClientPid)))
+					return false;
+			}
+
+			return true;
+		}
+
+
+		/// <summary>
+		/// Copy from ring at given (unwrapped) position into the buffer
+		/// </summary>
+		private void CopyFrom (byte* ring, long pos, byte[] buffer, int offset, int count)
+		{
+			var start = (int)(pos & _mask);
+			var first = Math.Min (count, _capacity - start);
+
+			Marshal.Copy ((IntPtr)(ring + start), buffer, offset, first);
+			if (first < count)
+				Marshal.Copy ((IntPtr)ring, buffer, offset + first, count - first);
+		}
+
+
+		/// <summary>
+		/// Copy from buffer into ring at given (unwrapped) position
+		/// </summary>
+		private void CopyTo (byte[] buffer, int offset, byte* ring, long pos, int count)
+		{
+			var start = (int)(pos & _mask);
+			var first = Math.Min (count, _capacity - start);
+
+			Marshal.Copy (buffer, offset, (IntPtr)(ring + start), first);
+			if (first < count)
+				Marshal.Copy (buffer, offset + first, (IntPtr)ring, count - first);
+		}
+
+
+		private static bool IsProcessAlive (int pid)
+		{
+			try
+			{
+				return !Process.GetProcessById (pid).HasExited;
+			}
+			catch (ArgumentException)
+			{
+				return false;
+			}
+		}
+
+
+		#endregion
+
+		// Header layout
+
+		private const int			OffMagic			= 0;
+		private const int			OffVersion			= 4;
+		private const int			OffCapacity			= 8;
+		private const int			OffState			= 12;
+		private const int			OffServerPid		= 16;
+		private const int			OffClientPid		= 20;
+		private const int			OffRequestHead		= 64;
+		private const int			OffRequestTail		= 128;
+		private const int			OffReplyHead		= 192;
+		private const int			OffReplyTail		= 256;
+
+		private static readonly int	SpinLimit			= Environment.ProcessorCount > 1 ? 1000 : 0;
+		private static readonly int	YieldLimit			= SpinLimit + 5000;
+
+		// Variables
+
+		private MemoryMappedFile			_file;
+		private MemoryMappedViewAccessor	_view;
+		private byte*						_base;
+		private int							_capacity;
+		private long						_mask;
+		private byte[]						_byte = new byte[1];
+	}
+}
+
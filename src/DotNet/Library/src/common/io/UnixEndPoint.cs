@@ -0,0 +1,107 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using System.Net;
+using System.Net.Sockets;
+using System.Text;
+
+
+namespace bridge.common.io
+{
+	/// <summary>
+	/// Endpoint for a unix domain (AF_UNIX) stream socket, addressed by filesystem path
+	/// </summary>
+	public class UnixEndPoint : EndPoint
+	{
+		public UnixEndPoint (string path)
+		{
+			if (string.IsNullOrEmpty (path))
+				throw new ArgumentException ("unix socket path must be provided");
+
+			Path = path;
+		}
+
+
+		// Properties
+
+		public string Path
+			{ get; private set; }
+
+		public override AddressFamily AddressFamily
+			{ get { return AddressFamily.Unix; } }
+
+
+		// Functions
+
+		/// <summary>
+		/// Create endpoint from socket address (sockaddr_un: family followed by a null terminated path)
+		/// </summary>
+		/// <param name="address">Address.</param>
+		public override EndPoint Create (SocketAddress address)
+		{
+			var len = address.Size - 2;
+			var bytes = new byte[len];
+			for (int i = 0 ; i < len ; i++)
+				bytes[i] = address[i + 2];
+
+			var end = Array.IndexOf (bytes, (byte)0);
+			var path = Encoding.UTF8.GetString (bytes, 0, end >= 0 ? end : len);
+
+			// unnamed (client side) sockets have no path
+			return path.Length > 0 ? new UnixEndPoint (path) : (EndPoint)new UnixEndPoint ("unnamed");
+		}
+
+
+		/// <summary>
+		/// Serialize endpoint into socket address
+		/// </summary>
+		public override SocketAddress Serialize ()
+		{
+			var bytes = Encoding.UTF8.GetBytes (Path);
+			var address = new SocketAddress (AddressFamily.Unix, 2 + bytes.Length + 1);
+			for (int i = 0 ; i < bytes.Length ; i++)
+				address[i + 2] = bytes[i];
+
+			address[2 + bytes.Length] = 0;
+			return address;
+		}
+
+
+		public override string ToString ()
+		{
+			return "unix://" + Path;
+		}
+
+		public override int GetHashCode ()
+		{
+			return Path.GetHashCode ();
+		}
+
+		public override bool Equals (object o)
+		{
+			var other = o as UnixEndPoint;
+			return other != null && other.Path == Path;
+		}
+	}
+}
+
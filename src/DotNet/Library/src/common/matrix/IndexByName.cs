@@ -36,21 +36,17 @@ namespace bridge.math.matrix
 	{
 		public IndexByName (params T[] names)
 		{
-			int i = 0;
 			foreach (T item in names)
 			{
 				Add(item);
-				_ordering[item.ToString()] = i++;
 			}
 		}
 		
 		public IndexByName (IEnumerable<T> c)
 		{
-			int i = 0;
 			foreach (T item in c)
 			{
 				Add(item);
-				_ordering[item.ToString()] = i++;
 			}
 		}
 		
@@ -77,7 +73,7 @@ namespace bridge.math.matrix
 			{ 
 				string[] list = new string[Count];
 				for (int i = 0 ; i < Count ; i++)
-					list[i] = this[i].ToString();
+					list[i] = this[i] != null ? this[i].ToString() : null;
 				
 				return list;
 			} 
@@ -97,8 +93,9 @@ namespace bridge.math.matrix
 		{
 			base.Add (name);
 			
-			var key = name.ToString();
-			_ordering[key] = Count-1;
+			// unnamed (null) positions cannot be looked up
+			if (name != null)
+				_ordering[name.ToString()] = Count-1;
 		}
 
 		
@@ -115,7 +112,11 @@ namespace bridge.math.matrix
 			
 			int i = 0;
 			foreach (var o in this)
-				_ordering[o.ToString()] = i++; 
+			{
+				if (o != null)
+					_ordering[o.ToString()] = i;
+				i++;
+			}
 		}
 		
 		
@@ -0,0 +1,333 @@
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+using System;
+using System.Collections;
+using System.Collections.Concurrent;
+using System.Collections.Generic;
+using System.Linq.Expressions;
+using System.Reflection;
+
+namespace bridge.common.reflection
+{
+	/// <summary>
+	/// Reads properties of each element of a collection into columns, one typed array per property, using
+	/// compiled getters cached by element type and property name
+	/// </summary>
+	public static class PropertyProjector
+	{
+		/// <summary>
+		/// Projects the named properties of the elements of the collection into columns.  Numeric properties
+		/// become int[], long[] or double[] columns, bools bool?[], strings and enums string[], and other
+		/// types object[].  Null elements (and nullable properties without a value) read as int.MinValue,
+		/// long.MinValue, NaN or null, according to the column type.  Elements of a collection of mixed types
+		/// are read through the common base type or, if the property is not declared there, through the
+		/// property on each element's own type.
+		/// </summary>
+		/// <param name="collection">Collection.</param>
+		/// <param name="properties">Property names.</param>
+		public static object[] Project (object collection, params string[] properties)
+		{
+			var enumerable = collection as IEnumerable;
+			if (enumerable == null || collection is string)
+				throw new ArgumentException ("Project: object is not a collection: " + (collection != null ? collection.GetType().ToString() : "null"));
+
+			var items = Snapshot (enumerable);
+			var type = ElementType (collection.GetType(), items);
+
+			var columns = new object[properties.Length];
+			for (int i = 0 ; i < properties.Length ; i++)
+			{
+				if (type == null)
+					columns[i] = new object[0];
+				else if (HasProperty (type, properties[i]))
+					columns[i] = AccessorFor (type, properties[i]).Column (items);
+				else
+					columns[i] = MixedColumn (items, properties[i]);
+			}
+
+			return columns;
+		}
+
+
+		#region Implementation
+
+
+		/// <summary>
+		/// Reads property across elements into a column
+		/// </summary>
+		private abstract class Accessor
+		{
+			public abstract Type ColumnType { get; }
+
+			public abstract object Value (object item);
+
+			public abstract Array Column (object[] items);
+		}
+
+
+		/// <summary>
+		/// Accessor with compiled getter yielding the column element type
+		/// </summary>
+		private class Accessor<T> : Accessor
+		{
+			public Accessor (Func<object,T> getter)
+			{
+				_getter = getter;
+			}
+
+			public override Type ColumnType
+				{ get { return typeof(T); } }
+
+			public override object Value (object item)
+			{
+				return _getter (item);
+			}
+
+			public override Array Column (object[] items)
+			{
+				var column = new T[items.Length];
+				for (int i = 0 ; i < items.Length ; i++)
+					column[i] = _getter (items[i]);
+
+				return column;
+			}
+
+			private Func<object,T>		_getter;
+		}
+
+
+		/// <summary>
+		/// Copy of the elements of the collection
+		/// </summary>
+		private static object[] Snapshot (IEnumerable collection)
+		{
+			var sized = collection as ICollection;
+			if (sized != null)
+			{
+				var items = new object[sized.Count];
+				sized.CopyTo (items, 0);
+				return items;
+			}
+
+			var list = new List<object>();
+			foreach (var item in collection)
+				list.Add (item);
+
+			return list.ToArray();
+		}
+
+
+		/// <summary>
+		/// Reads property of elements of differing types, with the accessor for each element's type, into a column
+		/// of the type common to their accessors (object[] if they differ)
+		/// </summary>
+		private static Array MixedColumn (object[] items, string name)
+		{
+			var accessors = new Accessor[items.Length];
+			Type ctype = null;
+			for (int i = 0 ; i < items.Length ; i++)
+			{
+				if (items[i] == null)
+					continue;
+
+				var accessor = accessors[i] = AccessorFor (items[i].GetType(), name);
+				if (ctype == null)
+					ctype = accessor.ColumnType;
+				else if (ctype != accessor.ColumnType)
+					ctype = typeof(object);
+			}
+
+			ctype = ctype ?? typeof(object);
+			var column = Array.CreateInstance (ctype, items.Length);
+			for (int i = 0 ; i < items.Length ; i++)
+				column.SetValue (accessors[i] != null ? accessors[i].Value (items[i]) : MissingOf (ctype), i);
+
+			return column;
+		}
+
+
+		/// <summary>
+		/// Element type of the collection, as declared (if IEnumerable&lt;T&gt; for T other than object), otherwise
+		/// the most derived type common to its elements (null if there are none)
+		/// </summary>
+		private static Type ElementType (Type ctype, object[] items)
+		{
+			foreach (var itype in ctype.GetInterfaces())
+			{
+				if (itype.IsGenericType && itype.GetGenericTypeDefinition() == typeof(IEnumerable<>))
+				{
+					var etype = itype.GetGenericArguments()[0];
+					if (etype != typeof(object))
+						return etype;
+				}
+			}
+
+			Type common = null;
+			foreach (var item in items)
+			{
+				if (item == null)
+					continue;
+				if (common == null)
+					common = item.GetType();
+
+				while (!common.IsInstanceOfType (item))
+					common = common.BaseType;
+			}
+
+			return common;
+		}
+
+
+		/// <summary>
+		/// Determine whether type has named (non-indexed) property
+		/// </summary>
+		private static bool HasProperty (Type type, string name)
+		{
+			var prop = type.GetProperty (name);
+			return prop != null && prop.GetIndexParameters().Length == 0;
+		}
+
+
+		/// <summary>
+		/// Accessor for property on type, created on first use
+		/// </summary>
+		private static Accessor AccessorFor (Type type, string name)
+		{
+			var key = Tuple.Create (type, name);
+
+			Accessor accessor = null;
+			if (!_accessors.TryGetValue (key, out accessor))
+				accessor = _accessors.GetOrAdd (key, CreateAccessor (type, name));
+
+			return accessor;
+		}
+
+
+		/// <summary>
+		/// Compiles getter for property on type, converting to the column element type
+		/// </summary>
+		private static Accessor CreateAccessor (Type type, string name)
+		{
+			var prop = type.GetProperty (name);
+			if (prop == null || prop.GetIndexParameters().Length > 0)
+				throw new ArgumentException ("Project: cannot find property " + name + " in " + type);
+
+			var ptype = prop.PropertyType;
+			var vtype = Nullable.GetUnderlyingType (ptype) ?? ptype;
+			var ctype = ColumnTypeOf (vtype);
+			var missing = Expression.Constant (MissingOf (ctype), ctype);
+
+			// missing if element is null, otherwise (for nullable properties) if no value
+			var obj = Expression.Parameter (typeof(object), "obj");
+			Expression value = Expression.Property (Expression.Convert (obj, type), prop);
+			if (vtype != ptype)
+			{
+				var held = Expression.Variable (ptype, "value");
+				value = Expression.Block (new [] { held },
+					Expression.Assign (held, value),
+					Expression.Condition (
+						Expression.Property (held, "HasValue"),
+						ToColumn (Expression.Property (held, "Value"), vtype, ctype),
+						missing));
+			}
+			else
+			{
+				value = ToColumn (value, vtype, ctype);
+			}
+
+			var body = Expression.Condition (Expression.Equal (obj, Expression.Constant (null)), missing, value);
+			var getter = Expression.Lambda (typeof(Func<,>).MakeGenericType (typeof(object), ctype), body, obj).Compile();
+
+			return (Accessor)Activator.CreateInstance (typeof(Accessor<>).MakeGenericType (ctype), getter);
+		}
+
+
+		/// <summary>
+		/// Converts property value to column element type
+		/// </summary>
+		private static Expression ToColumn (Expression value, Type vtype, Type ctype)
+		{
+			if (vtype == ctype)
+				return value;
+			if (vtype.IsEnum)
+				return Expression.Call (Expression.Convert (value, typeof(object)), typeof(object).GetMethod ("ToString"));
+			else
+				return Expression.Convert (value, ctype);
+		}
+
+
+		/// <summary>
+		/// Column element type for property value type
+		/// </summary>
+		private static Type ColumnTypeOf (Type vtype)
+		{
+			if (vtype.IsEnum)
+				return typeof(string);
+
+			Type ctype = null;
+			if (_columntypes.TryGetValue (vtype, out ctype))
+				return ctype;
+			else
+				return typeof(object);
+		}
+
+
+		/// <summary>
+		/// Value for a missing element or property value in column of the given type
+		/// </summary>
+		private static object MissingOf (Type ctype)
+		{
+			if (ctype == typeof(int))
+				return int.MinValue;
+			if (ctype == typeof(long))
+				return long.MinValue;
+			if (ctype == typeof(double))
+				return double.NaN;
+			else
+				return null;
+		}
+
+
+		#endregion
+
+		// Variables
+
+		static ConcurrentDictionary<Tuple<Type,string>,Accessor>	_accessors = new ConcurrentDictionary<Tuple<Type,string>,Accessor>();
+
+		static Dictionary<Type,Type>	_columntypes = new Dictionary<Type,Type>
+		{
+			{ typeof(bool), typeof(bool?) },
+			{ typeof(byte), typeof(int) },
+			{ typeof(sbyte), typeof(int) },
+			{ typeof(short), typeof(int) },
+			{ typeof(ushort), typeof(int) },
+			{ typeof(int), typeof(int) },
+			{ typeof(uint), typeof(long) },
+			{ typeof(long), typeof(long) },
+			{ typeof(float), typeof(double) },
+			{ typeof(double), typeof(double) },
+			{ typeof(decimal), typeof(double) },
+			{ typeof(string), typeof(string) }
+		};
+	}
+}
@@ -503,6 +503,24 @@ namespace bridge.common.reflection
         }
 
 
+        /// <summary>
+        /// Invokes a resolved method, conforming the arguments to its parameter types if needed
+        /// </summary>
+        /// <param name='obj'>
+        /// Target object (or null for a static method)
+        /// </param>
+        /// <param name='method'>
+        /// Method.
+        /// </param>
+        /// <param name='parameters'>
+        /// Parameters.
+        /// </param>
+        public static object InvokeMethod(object obj, MethodInfo method, params object[] parameters)
+        {
+            return CallMethod(obj, method, parameters);
+        }
+
+
         /// <summary>
         /// Finds the matching or closest method
         /// </summary>
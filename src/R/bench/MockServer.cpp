@@ -0,0 +1,488 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#include "MockServer.hpp"
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <stdexcept>
+#include <sstream>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+using namespace std;
+
+
+// protocol constants, mirroring CLRMessage
+static const uint16_t Magic                 = 0xd00d;
+
+static const uint8_t TypeNull               = 0;
+static const uint8_t TypeBool               = 1;
+static const uint8_t TypeByte               = 2;
+static const uint8_t TypeInt32              = 5;
+static const uint8_t TypeInt64              = 6;
+static const uint8_t TypeFloat64            = 7;
+static const uint8_t TypeString             = 8;
+static const uint8_t TypeVector             = 21;
+static const uint8_t TypeMatrix             = 22;
+static const uint8_t TypeInt32Array         = 105;
+static const uint8_t TypeFloat64Array       = 107;
+static const uint8_t TypeStringArray        = 108;
+static const uint8_t TypeCallStaticMethod   = 202;
+static const uint8_t TypeRelease            = 211;
+static const uint8_t TypeReleaseBatch       = 214;
+
+
+// append message header to buffer
+static void write_header (vector<uint8_t>& buffer, uint8_t type)
+{
+    buffer.push_back ((uint8_t)(Magic & 0xff));
+    buffer.push_back ((uint8_t)(Magic >> 8));
+    buffer.push_back (type);
+}
+
+// append int32 to buffer
+static void write_int32 (vector<uint8_t>& buffer, int32_t v)
+{
+    uint8_t* p = (uint8_t*)&v;
+    buffer.insert (buffer.end(), p, p + sizeof(v));
+}
+
+
+//
+//  Mock server
+//
+
+
+MockServer::MockServer (int port)
+    : _path(), _port(port), _listener(-1), _client(-1), _running(false), _received(0), _sent(0)
+{
+    listen_tcp();
+}
+
+
+MockServer::MockServer (const string& path)
+    : _path(path), _port(0), _listener(-1), _client(-1), _running(false), _received(0), _sent(0)
+{
+    listen_unix();
+}
+
+
+MockServer::~MockServer ()
+{
+    stop();
+}
+
+
+// host to connect to, as understood by CLRApi
+string MockServer::host () const
+{
+    if (_path.empty())
+        return "127.0.0.1";
+    else
+        return "unix://" + _path;
+}
+
+
+// start serving on a background thread
+void MockServer::start ()
+{
+    _running = true;
+    _thread = std::thread (&MockServer::run, this);
+}
+
+
+// stop serving and join the background thread
+void MockServer::stop ()
+{
+    _running = false;
+    if (_listener >= 0)
+    {
+        ::shutdown (_listener, SHUT_RDWR);
+        ::close (_listener);
+        _listener = -1;
+    }
+    int client = _client.load();
+    if (client >= 0)
+        ::shutdown (client, SHUT_RDWR);
+    if (_thread.joinable())
+        _thread.join();
+    if (!_path.empty())
+        ::unlink (_path.c_str());
+}
+
+
+// listen on loopback port
+void MockServer::listen_tcp ()
+{
+    _listener = ::socket (AF_INET, SOCK_STREAM, 0);
+    if (_listener < 0)
+        throw runtime_error ("mock server: could not create socket");
+
+    int on = 1;
+    ::setsockopt (_listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+
+    struct sockaddr_in addr;
+    memset (&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+    addr.sin_port = htons ((uint16_t)_port);
+
+    if (::bind (_listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || ::listen (_listener, 1) < 0)
+    {
+        ostringstream msg;
+        msg << "mock server: could not listen on port " << _port << ": " << strerror(errno);
+        throw runtime_error (msg.str());
+    }
+
+    socklen_t len = sizeof(addr);
+    ::getsockname (_listener, (struct sockaddr*)&addr, &len);
+    _port = ntohs (addr.sin_port);
+}
+
+
+// listen on unix domain socket
+void MockServer::listen_unix ()
+{
+    struct sockaddr_un addr;
+    if (_path.size() >= sizeof(addr.sun_path))
+        throw runtime_error ("mock server: unix domain socket path too long: " + _path);
+
+    ::unlink (_path.c_str());
+    _listener = ::socket (AF_UNIX, SOCK_STREAM, 0);
+    if (_listener < 0)
+        throw runtime_error ("mock server: could not create socket");
+
+    memset (&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy (addr.sun_path, _path.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (::bind (_listener, (struct sockaddr*)&addr, sizeof(addr)) < 0 || ::listen (_listener, 1) < 0)
+        throw runtime_error ("mock server: could not listen on " + _path + ": " + strerror(errno));
+}
+
+
+// accept and serve clients one at a time
+void MockServer::run ()
+{
+    while (_running)
+    {
+        int fd = ::accept (_listener, NULL, NULL);
+        if (fd < 0)
+            break;
+
+        _client = fd;
+
+        if (_path.empty())
+        {
+            int on = 1;
+            ::setsockopt (fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+
+        try
+        {
+            serve (fd);
+        }
+        catch (std::exception& e)
+        {
+            cerr << "mock server: " << e.what() << endl;
+        }
+
+        _client = -1;
+        ::close (fd);
+    }
+}
+
+
+// serve requests on connection until EOF
+void MockServer::serve (int fd)
+{
+    vector<uint8_t> reply;
+    reply.reserve (1 << 20);
+
+    while (_running)
+    {
+        uint8_t header[3];
+        if (!read_fully (fd, header, sizeof(header)))
+            return;
+
+        uint16_t magic = (uint16_t)(header[0] | (header[1] << 8));
+        if (magic != Magic)
+            throw runtime_error ("bad message magic");
+
+        switch (header[2])
+        {
+            case TypeCallStaticMethod:
+            {
+                string classname = read_string (fd);
+                string method = read_string (fd);
+
+                uint8_t count[2];
+                read_fully (fd, count, sizeof(count));
+                int argc = count[0] | (count[1] << 8);
+
+                reply.clear();
+                for (int i = 0 ; i < argc ; i++)
+                {
+                    if (i == 0 && method == "Echo")
+                        copy_value (fd, reply);
+                    else
+                    {
+                        vector<uint8_t> discard;
+                        copy_value (fd, discard);
+                    }
+                }
+
+                if (reply.empty())
+                    write_header (reply, TypeNull);
+
+                write_fully (fd, &reply[0], reply.size());
+                break;
+            }
+
+            case TypeRelease:
+                read_int32 (fd);
+                break;
+
+            case TypeReleaseBatch:
+                skip (fd, (size_t)read_int32 (fd) * sizeof(int32_t));
+                break;
+
+            default:
+            {
+                ostringstream msg;
+                msg << "unsupported request type: " << (int)header[2];
+                throw runtime_error (msg.str());
+            }
+        }
+    }
+}
+
+
+// copy a value message (header and body) from the socket into reply
+void MockServer::copy_value (int fd, vector<uint8_t>& reply)
+{
+    uint8_t header[3];
+    if (!read_fully (fd, header, sizeof(header)))
+        throw runtime_error ("unexpected EOF");
+
+    uint8_t type = header[2];
+    switch (type)
+    {
+        case TypeNull:
+            write_header (reply, type);
+            break;
+
+        case TypeBool:
+        case TypeByte:
+            write_header (reply, type);
+            copy_bytes (fd, reply, 1);
+            break;
+
+        case TypeInt32:
+            write_header (reply, type);
+            copy_bytes (fd, reply, 4);
+            break;
+
+        case TypeInt64:
+        case TypeFloat64:
+            write_header (reply, type);
+            copy_bytes (fd, reply, 8);
+            break;
+
+        case TypeString:
+        {
+            write_header (reply, type);
+            int32_t len = read_int32 (fd);
+            write_int32 (reply, len);
+            copy_bytes (fd, reply, len);
+            break;
+        }
+
+        case TypeVector:
+        {
+            // the server sees a Vector<double>, but replies with double[] as Float64Array
+            vector<uint8_t> names;
+            copy_strings (fd, names);
+            write_header (reply, TypeFloat64Array);
+            int32_t len = read_int32 (fd);
+            write_int32 (reply, len);
+            copy_bytes (fd, reply, (size_t)len * 8);
+            break;
+        }
+
+        case TypeMatrix:
+        {
+            write_header (reply, type);
+            copy_strings (fd, reply);
+            copy_strings (fd, reply);
+            int32_t nrow = read_int32 (fd);
+            int32_t ncol = read_int32 (fd);
+            write_int32 (reply, nrow);
+            write_int32 (reply, ncol);
+            copy_bytes (fd, reply, (size_t)nrow * ncol * 8);
+            break;
+        }
+
+        case TypeInt32Array:
+        {
+            write_header (reply, type);
+            int32_t len = read_int32 (fd);
+            write_int32 (reply, len);
+            copy_bytes (fd, reply, (size_t)len * 4);
+            break;
+        }
+
+        case TypeFloat64Array:
+        {
+            write_header (reply, type);
+            int32_t len = read_int32 (fd);
+            write_int32 (reply, len);
+            copy_bytes (fd, reply, (size_t)len * 8);
+            break;
+        }
+
+        case TypeStringArray:
+            write_header (reply, type);
+            copy_strings (fd, reply);
+            break;
+
+        default:
+        {
+            ostringstream msg;
+            msg << "unsupported value type: " << (int)type;
+            throw runtime_error (msg.str());
+        }
+    }
+}
+
+
+// copy length-prefixed list of strings
+void MockServer::copy_strings (int fd, vector<uint8_t>& reply)
+{
+    int32_t count = read_int32 (fd);
+    write_int32 (reply, count);
+    for (int32_t i = 0 ; i < count ; i++)
+    {
+        int32_t len = read_int32 (fd);
+        write_int32 (reply, len);
+        copy_bytes (fd, reply, len);
+    }
+}
+
+
+// copy len bytes from socket
+void MockServer::copy_bytes (int fd, vector<uint8_t>& reply, size_t len)
+{
+    size_t pos = reply.size();
+    reply.resize (pos + len);
+    if (len > 0 && !read_fully (fd, &reply[pos], len))
+        throw runtime_error ("unexpected EOF");
+}
+
+
+// read int32
+int32_t MockServer::read_int32 (int fd)
+{
+    int32_t v;
+    if (!read_fully (fd, &v, sizeof(v)))
+        throw runtime_error ("unexpected EOF");
+    return v;
+}
+
+
+// read string
+string MockServer::read_string (int fd)
+{
+    int32_t len = read_int32 (fd);
+    string s (len, '\0');
+    if (len > 0 && !read_fully (fd, &s[0], len))
+        throw runtime_error ("unexpected EOF");
+    return s;
+}
+
+
+// skip len bytes
+void MockServer::skip (int fd, size_t len)
+{
+    char buffer[4096];
+    while (len > 0)
+    {
+        size_t n = len < sizeof(buffer) ? len : sizeof(buffer);
+        if (!read_fully (fd, buffer, n))
+            throw runtime_error ("unexpected EOF");
+        len -= n;
+    }
+}
+
+
+// read len bytes, returning false on EOF
+bool MockServer::read_fully (int fd, void* buffer, size_t len)
+{
+    uint8_t* p = (uint8_t*)buffer;
+    while (len > 0)
+    {
+        ssize_t n = ::recv (fd, p, len, 0);
+        if (n == 0)
+            return false;
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw runtime_error (string("read failed: ") + strerror(errno));
+        }
+
+        p += n;
+        len -= n;
+        _received += n;
+    }
+
+    return true;
+}
+
+
+// write len bytes
+void MockServer::write_fully (int fd, const void* buffer, size_t len)
+{
+    const uint8_t* p = (const uint8_t*)buffer;
+    while (len > 0)
+    {
+        ssize_t n = ::send (fd, p, len, MSG_NOSIGNAL);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw runtime_error (string("write failed: ") + strerror(errno));
+        }
+
+        p += n;
+        len -= n;
+        _sent += n;
+    }
+}
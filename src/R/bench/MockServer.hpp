@@ -0,0 +1,103 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#ifndef MOCK_SERVER_H
+#define MOCK_SERVER_H
+
+#include <string>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+
+
+//
+//  In-process stand-in for the CLR server, speaking the 0xd00d protocol
+//
+//  Supports just enough of the protocol to measure the client side of the bridge:
+//
+//	- CallStatic ("Bench", "Echo", x) replies with x, where a numeric vector is returned
+//	  as a Float64Array (as the CLR server would for a double[] result)
+//	- CallStatic ("Bench", <other>, ...) replies with null
+//	- Release and ReleaseBatch are consumed without reply
+//
+class MockServer
+{
+  public:
+    // listen on a TCP loopback port (0 for ephemeral) or on a unix domain socket path
+    MockServer (int port);
+    MockServer (const std::string& path);
+    ~MockServer ();
+
+    // start serving on a background thread
+    void start ();
+
+    // stop serving and join the background thread
+    void stop ();
+
+    // host to connect to, as understood by CLRApi
+    std::string host () const;
+
+    // port to connect to (0 for unix domain sockets)
+    int port () const
+        { return _port; }
+
+    // total bytes received and sent on the wire
+    uint64_t bytes_received () const
+        { return _received.load(); }
+    uint64_t bytes_sent () const
+        { return _sent.load(); }
+
+  private:
+
+    void listen_tcp ();
+    void listen_unix ();
+
+    void run ();
+    void serve (int fd);
+
+    // read whole request, returning false on EOF
+    bool read_fully (int fd, void* buffer, size_t len);
+    void write_fully (int fd, const void* buffer, size_t len);
+
+    // copy a value message (header and body) from the socket into reply
+    void copy_value (int fd, std::vector<uint8_t>& reply);
+    void copy_bytes (int fd, std::vector<uint8_t>& reply, size_t len);
+    void copy_strings (int fd, std::vector<uint8_t>& reply);
+
+    int32_t read_int32 (int fd);
+    std::string read_string (int fd);
+    void skip (int fd, size_t len);
+
+  private:
+    std::string                 _path;
+    int                         _port;
+    int                         _listener;
+    std::atomic<int>            _client;
+    std::thread                 _thread;
+    std::atomic<bool>           _running;
+    std::atomic<uint64_t>       _received;
+    std::atomic<uint64_t>       _sent;
+};
+
+#endif
@@ -0,0 +1,348 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+//
+//  Client-side benchmark for the bridge
+//
+//  Runs the rDotNet serialization and transport code against an in-process mock of the
+//  CLR server (see MockServer), so needs neither mono nor .NET.  The msgs/ layer operates
+//  on R values, so R is embedded for the duration of the run.
+//
+//  Usage:
+//	bench [--transport tcp|unix] [--format csv|json] [--calls N] [--max-size N] [--out file]
+//
+//  Output is one record per (benchmark, type, size) with per-call latency percentiles
+//  in microseconds and wire throughput in MB/s (bytes sent plus bytes received).
+//
+
+#include "MockServer.hpp"
+#include "CLRApi.hpp"
+
+#include <Rembedded.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace Rcpp;
+using namespace std;
+
+
+// benchmark configuration
+struct Options
+{
+    string    transport = "unix";
+    string    format = "csv";
+    string    out;
+    int       calls = 20000;
+    int       maxsize = 1000000;
+};
+
+
+// result of a single benchmark run
+struct Result
+{
+    string    benchmark;
+    string    type;
+    int       size;
+    int       calls;
+    double    mean;
+    double    p50;
+    double    p90;
+    double    p99;
+    double    p999;
+    double    max;
+    double    mbps;
+};
+
+
+// bytes to produce in each throughput run, determining the number of calls per size
+static const double TargetBytes = 64e6;
+
+
+// print usage and exit
+static void usage ()
+{
+    cerr << "usage: bench [--transport tcp|unix] [--format csv|json] [--calls N] [--max-size N] [--out file]" << endl;
+    exit (1);
+}
+
+
+// parse command line
+static Options parse (int argc, char** argv)
+{
+    Options options;
+    for (int i = 1 ; i < argc ; i++)
+    {
+        string arg = argv[i];
+        if (i + 1 >= argc)
+            usage();
+
+        string value = argv[++i];
+        if (arg == "--transport")
+            options.transport = value;
+        else if (arg == "--format")
+            options.format = value;
+        else if (arg == "--out")
+            options.out = value;
+        else if (arg == "--calls")
+            options.calls = atoi (value.c_str());
+        else if (arg == "--max-size")
+            options.maxsize = atoi (value.c_str());
+        else
+            usage();
+    }
+
+    if (options.transport != "tcp" && options.transport != "unix")
+        usage();
+    if (options.format != "csv" && options.format != "json")
+        usage();
+    if (options.calls <= 0 || options.maxsize <= 0)
+        usage();
+
+    return options;
+}
+
+
+// start embedded R, with Rcpp loaded so that its registered routines are available
+static void start_R ()
+{
+    const char* argv[] = { "bench", "--vanilla", "--silent", "--no-save" };
+    Rf_initEmbeddedR (4, (char**)argv);
+
+    int error = 0;
+    SEXP call = PROTECT(Rf_lang2 (Rf_install("loadNamespace"), Rf_mkString("Rcpp")));
+    R_tryEval (call, R_GlobalEnv, &error);
+    UNPROTECT(1);
+
+    if (error)
+        throw std::runtime_error ("could not load Rcpp namespace");
+}
+
+
+// value at given quantile of sorted samples
+static double quantile (const vector<double>& sorted, double q)
+{
+    size_t i = (size_t)std::ceil (q * sorted.size());
+    return sorted[i > 0 ? i - 1 : 0];
+}
+
+
+// time repeated echo calls of given value against server
+static Result run (
+    CLRApi& api, MockServer& server, const string& benchmark, const string& type, int size, int calls, SEXP value)
+{
+    List argv = List::create (value);
+    vector<double> samples (calls);
+
+    // warm up connection and buffers
+    api.callstatic ("Bench", "Echo", argv);
+
+    uint64_t bytes0 = server.bytes_received() + server.bytes_sent();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+    for (int i = 0 ; i < calls ; i++)
+    {
+        chrono::steady_clock::time_point t0 = chrono::steady_clock::now();
+        RValue reply = api.callstatic ("Bench", "Echo", argv);
+        chrono::steady_clock::time_point t1 = chrono::steady_clock::now();
+        samples[i] = chrono::duration<double, std::micro>(t1 - t0).count();
+    }
+
+    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    uint64_t bytes = server.bytes_received() + server.bytes_sent() - bytes0;
+
+    sort (samples.begin(), samples.end());
+
+    double total = 0;
+    for (size_t i = 0 ; i < samples.size() ; i++)
+        total += samples[i];
+
+    Result result;
+    result.benchmark = benchmark;
+    result.type = type;
+    result.size = size;
+    result.calls = calls;
+    result.mean = total / calls;
+    result.p50 = quantile (samples, 0.50);
+    result.p90 = quantile (samples, 0.90);
+    result.p99 = quantile (samples, 0.99);
+    result.p999 = quantile (samples, 0.999);
+    result.max = samples.back();
+    result.mbps = bytes / elapsed / 1e6;
+    return result;
+}
+
+
+// generate value of given type and size
+static SEXP generate (const string& type, int size)
+{
+    if (type == "float64")
+    {
+        NumericVector v (size);
+        for (int i = 0 ; i < size ; i++)
+            v[i] = i * 0.5;
+        return v;
+    }
+    else if (type == "int32")
+    {
+        IntegerVector v (size);
+        for (int i = 0 ; i < size ; i++)
+            v[i] = i;
+        return v;
+    }
+    else if (type == "string")
+    {
+        StringVector v (size);
+        for (int i = 0 ; i < size ; i++)
+        {
+            ostringstream s;
+            s << "item-" << i;
+            v[i] = s.str();
+        }
+        return v;
+    }
+    else
+    {
+        int nrow = std::max (1, (int)std::sqrt ((double)size));
+        int ncol = std::max (1, size / nrow);
+        NumericMatrix m (nrow, ncol);
+        for (int i = 0 ; i < m.size() ; i++)
+            m[i] = i * 0.5;
+        return m;
+    }
+}
+
+
+// number of elements actually generated for type and size
+static int elements (const string& type, int size)
+{
+    if (type != "matrix")
+        return size;
+
+    int nrow = std::max (1, (int)std::sqrt ((double)size));
+    return nrow * std::max (1, size / nrow);
+}
+
+
+// write results as CSV
+static void write_csv (ostream& out, const vector<Result>& results)
+{
+    out << "benchmark,type,size,calls,mean_us,p50_us,p90_us,p99_us,p999_us,max_us,mb_per_sec" << endl;
+    for (size_t i = 0 ; i < results.size() ; i++)
+    {
+        const Result& r = results[i];
+        out << r.benchmark << "," << r.type << "," << r.size << "," << r.calls << ","
+            << r.mean << "," << r.p50 << "," << r.p90 << "," << r.p99 << ","
+            << r.p999 << "," << r.max << "," << r.mbps << endl;
+    }
+}
+
+
+// write results as JSON
+static void write_json (ostream& out, const Options& options, const vector<Result>& results)
+{
+    out << "{" << endl;
+    out << "  \"transport\": \"" << options.transport << "\"," << endl;
+    out << "  \"results\": [" << endl;
+    for (size_t i = 0 ; i < results.size() ; i++)
+    {
+        const Result& r = results[i];
+        out << "    { \"benchmark\": \"" << r.benchmark << "\", \"type\": \"" << r.type << "\""
+            << ", \"size\": " << r.size << ", \"calls\": " << r.calls
+            << ", \"mean_us\": " << r.mean << ", \"p50_us\": " << r.p50 << ", \"p90_us\": " << r.p90
+            << ", \"p99_us\": " << r.p99 << ", \"p999_us\": " << r.p999 << ", \"max_us\": " << r.max
+            << ", \"mb_per_sec\": " << r.mbps << " }" << (i + 1 < results.size() ? "," : "") << endl;
+    }
+    out << "  ]" << endl;
+    out << "}" << endl;
+}
+
+
+int main (int argc, char** argv)
+{
+    Options options = parse (argc, argv);
+    vector<Result> results;
+
+    try
+    {
+        start_R();
+
+        ostringstream path;
+        path << "/tmp/rdotnet-bench-" << getpid() << ".sock";
+
+        MockServer* server = options.transport == "unix" ? new MockServer (path.str()) : new MockServer (0);
+        server->start();
+
+        // note: not deleted, as closing the transport raises on an open connection
+        CLRApi* api = new CLRApi (server->host().c_str(), server->port(), 0);
+        api->start();
+
+        // round-trip latency of small calls
+        results.push_back (run (*api, *server, "latency", "float64", 1, options.calls, NumericVector::create (1.5)));
+        results.push_back (run (*api, *server, "latency", "int32", 1, options.calls, IntegerVector::create (42)));
+        results.push_back (run (*api, *server, "latency", "string", 1, options.calls, StringVector::create ("hello")));
+
+        // throughput across payload sizes
+        const char* types[] = { "float64", "int32", "string", "matrix" };
+        const double width[] = { 8, 4, 14, 8 };
+
+        for (int t = 0 ; t < 4 ; t++)
+        {
+            for (int size = 10 ; size <= options.maxsize ; size *= 10)
+            {
+                int n = elements (types[t], size);
+                int calls = std::max (5, std::min (options.calls, (int)(TargetBytes / (n * width[t]))));
+
+                RObject value = generate (types[t], size);
+                results.push_back (run (*api, *server, "throughput", types[t], n, calls, value));
+            }
+        }
+
+        server->stop();
+    }
+    catch (std::exception& e)
+    {
+        cerr << "bench: " << e.what() << endl;
+        return 1;
+    }
+
+    if (options.out.empty())
+    {
+        if (options.format == "csv") write_csv (cout, results); else write_json (cout, options, results);
+    }
+    else
+    {
+        ofstream out (options.out.c_str());
+        if (options.format == "csv") write_csv (out, results); else write_json (out, options, results);
+    }
+
+    return 0;
+}
@@ -12,7 +12,9 @@ using System.Collections;
 using System.Diagnostics;
 using System.Diagnostics; 
 using System.IO.Compression;
+using System.IO.MemoryMappedFiles;
 using System.IO;
+using System.Linq.Expressions;
 using System.Linq;
 using System.Net.Sockets;
 using System.Net;
@@ -22,6 +24,7 @@ using System.Runtime.ConstrainedExecution;
 using System.Runtime.InteropServices;
 using System.Text.RegularExpressions;
 using System.Text;
+using System.Threading.Tasks;
 using System.Threading;
 using System;
 using System; 
@@ -243,6 +246,160 @@ namespace bridge.embedded
 		{
 		}
 
+
+		/// <summary>
+		/// Resolves a method once, returning a handle with which it can be invoked
+		/// </summary>
+		/// <param name="classname">class name.</param>
+		/// <param name="method">Method name.</param>
+		/// <param name="argtypes">Argument type names, or null if the method name is not overloaded.</param>
+		public int Prepare (string classname, string method, string[] argtypes)
+		{
+			var signature = classname + "::" + method + (argtypes != null ? "(" + string.Join (",", argtypes) + ")" : "");
+
+			int handle = 0;
+			if (_handles.TryGetValue (signature, out handle))
+				return handle;
+
+			var type = ReflectUtils.FindType (classname);
+			if (type == null)
+				throw new ArgumentException ("Prepare: could not find specified type: " + classname);
+
+			var imethod = (argtypes != null) ? FindMethod (type, method, argtypes) : FindMethod (type, method);
+			lock (_methods)
+			{
+				if (_handles.TryGetValue (signature, out handle))
+					return handle;
+
+				handle = _methods.Count;
+				_methods.Add (imethod);
+				_handles[signature] = handle;
+				return handle;
+			}
+		}
+
+
+		/// <summary>
+		/// Invokes a prepared method (the first parameter is the target object for instance methods)
+		/// </summary>
+		/// <param name="handle">Handle returned by Prepare.</param>
+		/// <param name="parameters">Parameters.</param>
+		public object Invoke (int handle, params object[] parameters)
+		{
+			MethodInfo method = null;
+			lock (_methods)
+			{
+				if (handle < 0 || handle >= _methods.Count)
+					throw new ArgumentException ("Invoke: unknown method handle: " + handle);
+				method = _methods[handle];
+			}
+
+			if (method.IsStatic)
+				return ReflectUtils.InvokeMethod (null, method, parameters);
+
+			if (parameters.Length == 0 || parameters[0] == null)
+				throw new ArgumentException ("Invoke: instance method " + method.Name + " requires the target object as first argument");
+
+			var args = new object[parameters.Length - 1];
+			Array.Copy (parameters, 1, args, 0, args.Length);
+			return ReflectUtils.InvokeMethod (parameters[0], method, args);
+		}
+
+
+		/// <summary>
+		/// Reads the named properties of each element of a collection, returning one typed array (column) per property
+		/// </summary>
+		/// <param name="collection">Collection.</param>
+		/// <param name="properties">Property names.</param>
+		public object[] Project (object collection, params string[] properties)
+		{
+			return PropertyProjector.Project (collection, properties);
+		}
+
+
+		#region Implementation
+
+
+		/// <summary>
+		/// Find method with exactly the given argument types
+		/// </summary>
+		private static MethodInfo FindMethod (Type type, string name, string[] argtypes)
+		{
+			var types = new Type[argtypes.Length];
+			for (int i = 0 ; i < argtypes.Length ; i++)
+				types[i] = TypeForName (argtypes[i]);
+
+			var method = type.GetMethod (name, types);
+			if (method == null)
+				throw new ArgumentException ("Prepare: could not find method " + name + "(" + string.Join (",", argtypes) + ") in " + type);
+
+			return method;
+		}
+
+
+		/// <summary>
+		/// Find method by name, requiring that it not be overloaded
+		/// </summary>
+		private static MethodInfo FindMethod (Type type, string name)
+		{
+			MethodInfo found = null;
+			foreach (var method in type.GetMethods())
+			{
+				if (method.Name != name)
+					continue;
+				if (found != null)
+					throw new ArgumentException ("Prepare: method " + name + " in " + type + " is overloaded, argument types must be given");
+
+				found = method;
+			}
+
+			if (found == null)
+				throw new ArgumentException ("Prepare: could not find method " + name + " in " + type);
+
+			return found;
+		}
+
+
+		/// <summary>
+		/// Resolve type by name, allowing C# aliases such as double or int[]
+		/// </summary>
+		private static Type TypeForName (string name)
+		{
+			if (name.EndsWith ("[]"))
+				return TypeForName (name.Substring (0, name.Length - 2)).MakeArrayType();
+
+			Type type = null;
+			if (_aliases.TryGetValue (name, out type))
+				return type;
+
+			type = ReflectUtils.FindType (name);
+			if (type == null)
+				throw new ArgumentException ("Prepare: could not find argument type: " + name);
+
+			return type;
+		}
+
+
+		#endregion
+
+		// Variables
+
+		static IDictionary<string,int>		_handles = new ConcurrentDictionary<string, int>();
+		static List<MethodInfo>				_methods = new List<MethodInfo>();
+
+		static IDictionary<string,Type>		_aliases = new Dictionary<string, Type>
+		{
+			{ "bool", typeof(bool) },
+			{ "byte", typeof(byte) },
+			{ "char", typeof(char) },
+			{ "short", typeof(short) },
+			{ "int", typeof(int) },
+			{ "long", typeof(long) },
+			{ "float", typeof(float) },
+			{ "double", typeof(double) },
+			{ "string", typeof(string) },
+			{ "object", typeof(object) }
+		};
 	}
 }
 
@@ -418,6 +575,31 @@ namespace bridge
 		/// <param name="obj">Object.</param>
 		void						Release (object obj);
 
+
+		/// <summary>
+		/// Resolves a method once, returning a handle with which it can be invoked
+		/// </summary>
+		/// <param name="classname">class name.</param>
+		/// <param name="method">Method name.</param>
+		/// <param name="argtypes">Argument type names, or null if the method name is not overloaded.</param>
+		int							Prepare (string classname, string method, string[] argtypes);
+
+
+		/// <summary>
+		/// Invokes a prepared method (the first parameter is the target object for instance methods)
+		/// </summary>
+		/// <param name="handle">Handle returned by Prepare.</param>
+		/// <param name="parameters">Parameters.</param>
+		object						Invoke (int handle, params object[] parameters);
+
+
+		/// <summary>
+		/// Reads the named properties of each element of a collection, returning one typed array (column) per property
+		/// </summary>
+		/// <param name="collection">Collection.</param>
+		/// <param name="properties">Property names.</param>
+		object[]					Project (object collection, params string[] properties);
+
 	}
 }
 
@@ -698,6 +880,55 @@ namespace bridge.server
 		}
 
 
+		/// <summary>
+		/// Resolves a method once, returning a handle with which it can be invoked
+		/// </summary>
+		/// <param name="classname">class name.</param>
+		/// <param name="method">Method name.</param>
+		/// <param name="argtypes">Argument type names, or null if the method name is not overloaded.</param>
+		public int Prepare (string classname, string method, string[] argtypes)
+		{
+			// send request
+			var req = new CLRPrepareMessage (classname, method, argtypes);
+			CLRMessage.Write (_cout, req);
+			
+			// get response
+			return (int)CLRMessage.ReadValue (_cin);
+		}
+
+
+		/// <summary>
+		/// Invokes a prepared method (the first parameter is the target object for instance methods)
+		/// </summary>
+		/// <param name="handle">Handle returned by Prepare.</param>
+		/// <param name="parameters">Parameters.</param>
+		public object Invoke (int handle, params object[] parameters)
+		{
+			// send request
+			var req = new CLRInvokeMessage (handle, parameters);
+			CLRMessage.Write (_cout, req);
+			
+			// get response
+			return CLRMessage.ReadValue (_cin);
+		}
+
+
+		/// <summary>
+		/// Reads the named properties of each element of a collection, returning one typed array (column) per property
+		/// </summary>
+		/// <param name="collection">Collection.</param>
+		/// <param name="properties">Property names.</param>
+		public object[] Project (object collection, params string[] properties)
+		{
+			// send request
+			var req = new CLRProjectMessage (collection, properties);
+			CLRMessage.Write (_cout, req);
+			
+			// get response
+			return (object[])CLRMessage.ReadValue (_cin);
+		}
+
+
 		#region Implementation
 		
 		
@@ -793,6 +1024,10 @@ namespace bridge.server
 		public CLRBridgeServer (Uri url)
 			: this (url.Port)
 		{
+			if (url.Scheme == "unix")
+				_path = url.AbsolutePath;
+			if (url.Scheme == "shm")
+				_shm_path = url.AbsolutePath;
 		}
 
 		public CLRBridgeServer(int port)
@@ -818,12 +1053,12 @@ namespace bridge.server
 
 			if (!blocking)
 			{
-				var worker = new Thread(_ => Service());
+				var worker = new Thread(_ => Serve());
 				worker.Start();
 			}
 			else
 			{
-				Service ();
+				Serve ();
 			}
 		}
 
@@ -837,6 +1072,11 @@ namespace bridge.server
 		/// </summary>
 		private bool SetupListener ()
 		{
+			if (_path != null)
+				return SetupUnixListener ();
+			if (_shm_path != null)
+				return SetupSharedMemory ();
+
 			_log.Info("starting execution server listener on port: " + _port);
 			var mask = new IPEndPoint(IPAddress.Any, _port);
 			_server_socket = new Socket(AddressFamily.InterNetwork, SocketType.Stream, ProtocolType.Tcp);
@@ -860,6 +1100,82 @@ namespace bridge.server
 		}
 
 
+		/// <summary>
+		/// Setup server on a unix domain socket (same-host clients, avoids the TCP/IP stack)
+		/// </summary>
+		private bool SetupUnixListener ()
+		{
+			_log.Info("starting execution server listener on unix socket: " + _path);
+			var mask = new UnixEndPoint (_path);
+
+			// socket file left behind by a previous server must be removed before binding
+			if (File.Exists (_path))
+			{
+				if (IsUnixListenerAlive (mask))
+				{
+					_log.Warn("another CLR server already running, exiting");
+					return false;
+				}
+
+				File.Delete (_path);
+			}
+
+			_server_socket = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified);
+			_server_socket.Bind(mask);
+			_server_socket.Listen(10);
+			return true;
+		}
+
+
+		/// <summary>
+		/// Setup shared memory rings for a co-located client (replaces the socket entirely)
+		/// </summary>
+		private bool SetupSharedMemory ()
+		{
+			_log.Info("starting execution server on shared memory: " + _shm_path);
+			if (SharedMemoryStream.IsServerAlive (_shm_path))
+			{
+				_log.Warn("another CLR server already running, exiting");
+				return false;
+			}
+
+			_shm = new SharedMemoryStream (_shm_path);
+			return true;
+		}
+
+
+		/// <summary>
+		/// Determine whether some process is accepting connections on the given unix socket
+		/// </summary>
+		private static bool IsUnixListenerAlive (UnixEndPoint endpoint)
+		{
+			using (var probe = new Socket(AddressFamily.Unix, SocketType.Stream, ProtocolType.Unspecified))
+			{
+				try
+				{
+					probe.Connect (endpoint);
+					return true;
+				}
+				catch (SocketException)
+				{
+					return false;
+				}
+			}
+		}
+
+
+		/// <summary>
+		/// Service clients on the configured transport
+		/// </summary>
+		private void Serve ()
+		{
+			if (_shm != null)
+				ServiceSharedMemory ();
+			else
+				Service ();
+		}
+
+
         /// <summary>
         /// Handle incoming clients
         /// </summary>
@@ -870,7 +1186,8 @@ namespace bridge.server
                 var client_socket = _server_socket.Accept();
 
                 _log.Info("execution: received new client from: " + client_socket.RemoteEndPoint);
-				client_socket.NoDelay = true;
+				if (client_socket.AddressFamily != AddressFamily.Unix)
+					client_socket.NoDelay = true;
 				var stream = new BufferedDuplexStream(new NetworkStream(client_socket));
                 var client = new CLRBridgeServerClient (stream, client_socket.RemoteEndPoint);
 
@@ -879,11 +1196,33 @@ namespace bridge.server
         }
 
 
+		/// <summary>
+		/// Handle clients attaching to the shared memory rings, one at a time
+		/// </summary>
+		private void ServiceSharedMemory ()
+		{
+			while (true)
+			{
+				_shm.Accept ();
+
+				_log.Info("execution: received new client on shared memory: " + _shm_path);
+				var client = new CLRBridgeServerClient (new BufferedDuplexStream(_shm), null);
+
+				client.Start();
+				client.Join();
+				_shm.Disconnect ();
+			}
+		}
+
+
 		#endregion
 
         // Variables
 
 		private int				_port;
+		private string			_path;
+		private string			_shm_path;
+		private SharedMemoryStream	_shm;
         private Socket			_server_socket;
 
         static Logger			_log = Logger.Get("CLR");
@@ -966,6 +1305,15 @@ namespace bridge.server
 		}
 
 
+		/// <summary>
+		/// Wait for the client to finish
+		/// </summary>
+		public void Join ()
+		{
+			_servicer.Join();
+		}
+
+
 		#region Service
 
 
@@ -1025,10 +1373,38 @@ namespace bridge.server
 							HandleRelease (msg as CLRReleaseMessage);
 							break;
 
+						case CLRMessage.TypeReleaseBatch:
+							HandleReleaseBatch (msg as CLRReleaseBatchMessage);
+							break;
+
 						case CLRMessage.TypeTemplateReq:
 							HandleTemplate (msg as CLRTemplateReqMessage);
 							break;
 
+						case CLRMessage.TypePrepare:
+							HandlePrepare (msg as CLRPrepareMessage);
+							break;
+
+						case CLRMessage.TypeInvoke:
+							HandleInvoke (msg as CLRInvokeMessage);
+							break;
+
+						case CLRMessage.TypeCompression:
+							HandleCompression (msg as CLRCompressionMessage);
+							break;
+
+						case CLRMessage.TypeChain:
+							HandleChain (msg as CLRChainMessage);
+							break;
+
+						case CLRMessage.TypeGetProperties:
+							HandleGetProperties (msg as CLRGetPropertiesMessage);
+							break;
+
+						case CLRMessage.TypeProject:
+							HandleProject (msg as CLRProjectMessage);
+							break;
+
 						default:
 							throw new ArgumentException ("unknown request message: " + msg);
 					}
@@ -1134,43 +1510,37 @@ namespace bridge.server
 		
 
 		/// <summary>
-		/// Gets property on object.
+		/// Resolves a method, replying with its handle
 		/// </summary>
 		/// <param name="req">Req.</param>
-		private void HandleGetProperty (CLRGetPropertyMessage req)
+		private void HandlePrepare (CLRPrepareMessage req)
 		{
 			try
 			{
-				// get object
-				var obj = ToLocalObject (req.Obj);
-				// invoke
-				var result = _api.GetProperty (obj, req.PropertyName);
-				CLRMessage.WriteValue (_cout, result);
-			}
-			catch (TargetInvocationException te)
-			{
-				CLRMessage.WriteValue (_cout, te.GetBaseException());
+				var handle = _api.Prepare (req.ClassName, req.MethodName, req.ArgTypes);
+				CLRMessage.WriteValue (_cout, handle);
 			}
 			catch (Exception e)
 			{
 				CLRMessage.WriteValue (_cout, e);
 			}
 		}
-		
-		
+
+
 		/// <summary>
-		/// Sets property on object.
+		/// Calls a prepared method.
 		/// </summary>
 		/// <param name="req">Req.</param>
-		private void HandleSetProperty (CLRSetPropertyMessage req)
+		private void HandleInvoke (CLRInvokeMessage req)
 		{
 			try
 			{
-				// get object
-				var obj = ToLocalObject (req.Obj);
-				// invoke
-				_api.SetProperty (obj, req.PropertyName, req.Value);
-				CLRMessage.WriteValue (_cout, null);
+				var parameters = req.Parameters;
+				if (parameters.Length > 0)
+					parameters[0] = ToLocalObject (parameters[0]);
+
+				var result = _api.Invoke (req.Handle, parameters);
+				CLRMessage.WriteValue (_cout, result);
 			}
 			catch (TargetInvocationException te)
 			{
@@ -1182,18 +1552,51 @@ namespace bridge.server
 			}
 		}
 		
-		
+
 		/// <summary>
-		/// Gets static property on class.
+		/// Evaluates a chain of calls and gets, each on the result of the previous, replying with the final value
+		/// (intermediate objects are not registered as proxies)
 		/// </summary>
 		/// <param name="req">Req.</param>
-		private void HandleGetStaticProperty (CLRGetStaticPropertyMessage req)
+		private void HandleChain (CLRChainMessage req)
 		{
 			try
 			{
-				// invoke
-				var result = _api.GetStaticProperty (req.ClassName, req.PropertyName);
-				CLRMessage.WriteValue (_cout, result);
+				bool isstatic = req.ClassName.Length > 0;
+				var obj = isstatic ? null : ToLocalObject (req.Obj);
+
+				for (int i = 0 ; i < req.Steps.Length ; i++)
+				{
+					var step = req.Steps[i];
+					if (!(isstatic && i == 0) && obj == null)
+						throw new ArgumentException ("cannot apply " + step.Name + " to null (step " + (i+1) + " of chain)");
+
+					switch (step.Kind)
+					{
+						case CLRChainMessage.StepCall:
+							obj = (isstatic && i == 0) ?
+								_api.CallStaticMethodByName (req.ClassName, step.Name, step.Parameters) :
+								_api.CallMethod (obj, step.Name, step.Parameters);
+							break;
+
+						case CLRChainMessage.StepGet:
+							obj = (isstatic && i == 0) ?
+								_api.GetStaticProperty (req.ClassName, step.Name) :
+								_api.GetProperty (obj, step.Name);
+							break;
+
+						case CLRChainMessage.StepIndex:
+							if (isstatic && i == 0)
+								throw new ArgumentException ("cannot index class " + req.ClassName);
+							obj = _api.GetIndexed (obj, Convert.ToInt32 (step.Parameters[0]));
+							break;
+
+						default:
+							throw new ArgumentException ("unknown chain step: " + step.Kind);
+					}
+				}
+
+				CLRMessage.WriteValue (_cout, obj);
 			}
 			catch (TargetInvocationException te)
 			{
@@ -1205,18 +1608,144 @@ namespace bridge.server
 			}
 		}
 		
-		
+
 		/// <summary>
-		/// Sets static property on class.
+		/// Gets property on object.
 		/// </summary>
 		/// <param name="req">Req.</param>
-		private void HandleSetStaticProperty (CLRSetStaticPropertyMessage req)
+		private void HandleGetProperty (CLRGetPropertyMessage req)
 		{
 			try
 			{
+				// get object
+				var obj = ToLocalObject (req.Obj);
 				// invoke
-				_api.SetProperty (req.ClassName, req.PropertyName, req.Value);
-				CLRMessage.WriteValue (_cout, null);
+				var result = _api.GetProperty (obj, req.PropertyName);
+				CLRMessage.WriteValue (_cout, result);
+			}
+			catch (TargetInvocationException te)
+			{
+				CLRMessage.WriteValue (_cout, te.GetBaseException());
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+		
+		
+		/// <summary>
+		/// Gets several properties of an object, replying with their values as an object array
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandleGetProperties (CLRGetPropertiesMessage req)
+		{
+			try
+			{
+				// get object
+				var obj = ToLocalObject (req.Obj);
+
+				var names = req.PropertyNames;
+				var values = new object[names.Length];
+				for (int i = 0 ; i < names.Length ; i++)
+					values[i] = _api.GetProperty (obj, names[i]);
+
+				CLRMessage.WriteValue (_cout, values);
+			}
+			catch (TargetInvocationException te)
+			{
+				CLRMessage.WriteValue (_cout, te.GetBaseException());
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+		
+		
+		/// <summary>
+		/// Reads properties of each element of a collection, replying with one typed column per property
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandleProject (CLRProjectMessage req)
+		{
+			try
+			{
+				// get collection
+				var collection = ToLocalObject (req.Obj);
+				var columns = _api.Project (collection, req.PropertyNames);
+				CLRMessage.WriteValue (_cout, columns);
+			}
+			catch (TargetInvocationException te)
+			{
+				CLRMessage.WriteValue (_cout, te.GetBaseException());
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+		
+		
+		/// <summary>
+		/// Sets property on object.
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandleSetProperty (CLRSetPropertyMessage req)
+		{
+			try
+			{
+				// get object
+				var obj = ToLocalObject (req.Obj);
+				// invoke
+				_api.SetProperty (obj, req.PropertyName, req.Value);
+				CLRMessage.WriteValue (_cout, null);
+			}
+			catch (TargetInvocationException te)
+			{
+				CLRMessage.WriteValue (_cout, te.GetBaseException());
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+		
+		
+		/// <summary>
+		/// Gets static property on class.
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandleGetStaticProperty (CLRGetStaticPropertyMessage req)
+		{
+			try
+			{
+				// invoke
+				var result = _api.GetStaticProperty (req.ClassName, req.PropertyName);
+				CLRMessage.WriteValue (_cout, result);
+			}
+			catch (TargetInvocationException te)
+			{
+				CLRMessage.WriteValue (_cout, te.GetBaseException());
+			}
+			catch (Exception e)
+			{
+				CLRMessage.WriteValue (_cout, e);
+			}
+		}
+		
+		
+		/// <summary>
+		/// Sets static property on class.
+		/// </summary>
+		/// <param name="req">Req.</param>
+		private void HandleSetStaticProperty (CLRSetStaticPropertyMessage req)
+		{
+			try
+			{
+				// invoke
+				_api.SetProperty (req.ClassName, req.PropertyName, req.Value);
+				CLRMessage.WriteValue (_cout, null);
 			}
 			catch (TargetInvocationException te)
 			{
@@ -1298,6 +1827,35 @@ namespace bridge.server
 		}
 
 
+		/// <summary>
+		/// Sets the size from which values sent to this client are compressed
+		/// </summary>
+		/// <param name="req">Request.</param>
+		private void HandleCompression (CLRCompressionMessage req)
+		{
+			if (req.Codec != CLRCompressedMessage.CodecDeflate)
+			{
+				CLRMessage.WriteValue (_cout, new ArgumentException ("unsupported compression codec: " + req.Codec));
+				return;
+			}
+
+			// this thread serves only this client
+			CLRCompressedMessage.Threshold = Math.Max (req.Threshold, 0);
+			CLRMessage.WriteValue (_cout, null);
+		}
+
+
+		/// <summary>
+		/// Releases a batch of objects for GCing
+		/// </summary>
+		/// <param name="req">Request.</param>
+		private void HandleReleaseBatch (CLRReleaseBatchMessage req)
+		{
+			foreach (var id in req.ObjectIds)
+				CLRObjectProxy.Release (id);
+		}
+
+
 		#endregion
 
 		#region Miscellaneous
@@ -1427,7 +1985,13 @@ namespace bridge.server
 			var msg = Create (type);
 
 			msg.Deserialize (stream);
-			return msg;
+
+			// compressed envelope: read the message it carries in its place
+			var envelope = msg as CLRCompressedMessage;
+			if (envelope != null)
+				return Read (envelope.Reader);
+			else
+				return msg;
 		}
 
 
@@ -1499,6 +2063,8 @@ namespace bridge.server
 					return new CLRBoolArrayMessage ();
 				case TypeByteArray:
 					return new CLRByteArrayMessage ();
+				case TypeFloat32Array:
+					return new CLRFloat32ArrayMessage ();
 				case TypeInt32Array:
 					return new CLRInt32ArrayMessage ();
 				case TypeInt64Array:
@@ -1509,6 +2075,8 @@ namespace bridge.server
 					return new CLRStringArrayMessage ();
 				case TypeObjectArray:
 					return new CLRObjectArrayMessage ();
+				case TypeBitArray:
+					return new CLRBitArrayMessage ();
 				
 				case TypeVector:
 					return new CLRVectorMessage ();
@@ -1516,6 +2084,8 @@ namespace bridge.server
 					return new CLRMatrixMessage ();
 				case TypeException:
 					return new CLRExceptionMessage ();
+				case TypeCompressed:
+					return new CLRCompressedMessage ();
 
 				case TypeCreate:
 					return new CLRCreateMessage ();
@@ -1539,6 +2109,20 @@ namespace bridge.server
 					return new CLRProtectMessage ();
 				case TypeRelease:
 					return new CLRReleaseMessage ();
+				case TypeReleaseBatch:
+					return new CLRReleaseBatchMessage ();
+				case TypePrepare:
+					return new CLRPrepareMessage ();
+				case TypeInvoke:
+					return new CLRInvokeMessage ();
+				case TypeCompression:
+					return new CLRCompressionMessage ();
+				case TypeChain:
+					return new CLRChainMessage ();
+				case TypeGetProperties:
+					return new CLRGetPropertiesMessage ();
+				case TypeProject:
+					return new CLRProjectMessage ();
 
 				case TypeTemplateReq:
 					return new CLRTemplateReqMessage ();
@@ -1624,6 +2208,10 @@ namespace bridge.server
 					msg = new CLRByteArrayMessage ((byte[])val);
 					break;
 
+				case TypeFloat32Array:
+					msg = new CLRFloat32ArrayMessage ((float[])val);
+					break;
+
 				case TypeInt32Array:
 					msg = new CLRInt32ArrayMessage ((int[])val);
 					break;
@@ -1644,6 +2232,13 @@ namespace bridge.server
 					msg = new CLRObjectArrayMessage ((object[])val);
 					break;
 
+				case TypeBitArray:
+					if (val is bool[])
+						msg = new CLRBitArrayMessage ((bool[])val);
+					else
+						msg = new CLRBitArrayMessage ((bool?[])val);
+					break;
+
 				case TypeVector:
 					msg = new CLRVectorMessage ((Vector<double>)val);
 					break;
@@ -1660,7 +2255,10 @@ namespace bridge.server
 					throw new ArgumentException ("do not know how to serialize: " + val.GetType());
 			}
 
-			msg.Serialize (cout);
+			if (CLRCompressedMessage.Threshold > 0 && CLRCompressedMessage.WidthOf (msg.MessageType) > 0)
+				CLRCompressedMessage.Write (cout, msg);
+			else
+				msg.Serialize (cout);
 		}
 
 
@@ -1704,6 +2302,9 @@ namespace bridge.server
 				case TypeByteArray:
 					return ((CLRByteArrayMessage)msg).Value;
 
+				case TypeFloat32Array:
+					return ((CLRFloat32ArrayMessage)msg).Value;
+
 				case TypeInt32Array:
 					return ((CLRInt32ArrayMessage)msg).Value;
 
@@ -1719,6 +2320,9 @@ namespace bridge.server
 				case TypeObjectArray:
 					return ((CLRObjectArrayMessage)msg).Value;
 
+				case TypeBitArray:
+					return ((CLRBitArrayMessage)msg).ToObject();
+
 				case TypeVector:
 					return ((CLRVectorMessage)msg).Value;
 
@@ -1736,6 +2340,215 @@ namespace bridge.server
 
 		#endregion 
 
+		#region Bulk IO
+
+
+		/// <summary>
+		/// Write an array of doubles in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="values">Values.</param>
+		/// <param name="count">Number of values to write.</param>
+		protected static void WriteDoubles (IBinaryWriter cout, double[] values, int count)
+		{
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					cout.WriteDouble (values[i]);
+				return;
+			}
+
+			var chunk = new byte[Math.Min (count * 8, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 8);
+				Buffer.BlockCopy (values, i * 8, chunk, 0, n * 8);
+				cout.Write (chunk, 0, n * 8);
+				i += n;
+			}
+		}
+
+
+		/// <summary>
+		/// Read an array of doubles in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <returns>The values.</returns>
+		/// <param name="cin">Cin.</param>
+		/// <param name="count">Number of values to read.</param>
+		protected static double[] ReadDoubles (IBinaryReader cin, int count)
+		{
+			var values = new double[count];
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					values[i] = cin.ReadDouble ();
+				return values;
+			}
+
+			var chunk = new byte[Math.Min (count * 8, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 8);
+				if (cin.Read (chunk, 0, n * 8) < n * 8)
+					throw new EndOfStreamException ("end of stream reached while reading array");
+
+				Buffer.BlockCopy (chunk, 0, values, i * 8, n * 8);
+				i += n;
+			}
+
+			return values;
+		}
+
+
+		/// <summary>
+		/// Write an array of longs in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="values">Values.</param>
+		/// <param name="count">Number of values to write.</param>
+		protected static void WriteLongs (IBinaryWriter cout, long[] values, int count)
+		{
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					cout.WriteInt64 (values[i]);
+				return;
+			}
+
+			var chunk = new byte[Math.Min (count * 8, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 8);
+				Buffer.BlockCopy (values, i * 8, chunk, 0, n * 8);
+				cout.Write (chunk, 0, n * 8);
+				i += n;
+			}
+		}
+
+
+		/// <summary>
+		/// Read an array of longs in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <returns>The values.</returns>
+		/// <param name="cin">Cin.</param>
+		/// <param name="count">Number of values to read.</param>
+		protected static long[] ReadLongs (IBinaryReader cin, int count)
+		{
+			var values = new long[count];
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					values[i] = cin.ReadInt64 ();
+				return values;
+			}
+
+			var chunk = new byte[Math.Min (count * 8, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 8);
+				if (cin.Read (chunk, 0, n * 8) < n * 8)
+					throw new EndOfStreamException ("end of stream reached while reading array");
+
+				Buffer.BlockCopy (chunk, 0, values, i * 8, n * 8);
+				i += n;
+			}
+
+			return values;
+		}
+
+
+		/// <summary>
+		/// Write an array of floats in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="values">Values.</param>
+		/// <param name="count">Number of values to write.</param>
+		protected static void WriteFloats (IBinaryWriter cout, float[] values, int count)
+		{
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					cout.WriteUInt32 (BitConverter.ToUInt32 (BitConverter.GetBytes (values[i]), 0));
+				return;
+			}
+
+			var chunk = new byte[Math.Min (count * 4, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 4);
+				Buffer.BlockCopy (values, i * 4, chunk, 0, n * 4);
+				cout.Write (chunk, 0, n * 4);
+				i += n;
+			}
+		}
+
+
+		/// <summary>
+		/// Read an array of floats in bulk (little-endian layout as used on the wire)
+		/// </summary>
+		/// <returns>The values.</returns>
+		/// <param name="cin">Cin.</param>
+		/// <param name="count">Number of values to read.</param>
+		protected static float[] ReadFloats (IBinaryReader cin, int count)
+		{
+			var values = new float[count];
+			if (!BitConverter.IsLittleEndian)
+			{
+				for (int i = 0 ; i < count ; i++)
+					values[i] = BitConverter.ToSingle (BitConverter.GetBytes (cin.ReadUInt32 ()), 0);
+				return values;
+			}
+
+			var chunk = new byte[Math.Min (count * 4, BulkChunkSize)];
+			for (int i = 0 ; i < count ; )
+			{
+				var n = Math.Min (count - i, chunk.Length / 4);
+				if (cin.Read (chunk, 0, n * 4) < n * 4)
+					throw new EndOfStreamException ("end of stream reached while reading array");
+
+				Buffer.BlockCopy (chunk, 0, values, i * 4, n * 4);
+				i += n;
+			}
+
+			return values;
+		}
+
+
+		/// <summary>
+		/// Write a UTF-8 string, or a length of -1 for null (NA in R)
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="value">Value.</param>
+		protected static void WriteStringOrNull (IBinaryWriter cout, string value)
+		{
+			if (value != null)
+				cout.WriteString (value, Encoding.UTF8);
+			else
+				cout.WriteInt32 (NullLength);
+		}
+
+
+		/// <summary>
+		/// Read a UTF-8 string, null if sent with a length of -1
+		/// </summary>
+		/// <returns>The string.</returns>
+		/// <param name="cin">Cin.</param>
+		protected static string ReadStringOrNull (IBinaryReader cin)
+		{
+			var len = cin.ReadInt32();
+			if (len == NullLength)
+				return null;
+
+			var data = new byte[len];
+			if (cin.Read (data, 0, len) < len)
+				throw new EndOfStreamException ("end of stream reached while reading string");
+
+			return Encoding.UTF8.GetString (data);
+		}
+
+
+		#endregion
+
 		#region Message Types
 
 		public const ushort			Magic						= 0xd00d;
@@ -1752,14 +2565,17 @@ namespace bridge.server
 		public const byte			TypeVector					= 21;
 		public const byte			TypeMatrix					= 22;
 		public const byte			TypeException				= 23;
+		public const byte			TypeCompressed				= 24;
 
 		public const byte			TypeBoolArray				= 101;
 		public const byte			TypeByteArray				= 102;
+		public const byte			TypeFloat32Array			= 103;
 		public const byte			TypeInt32Array				= 105;
 		public const byte			TypeInt64Array				= 106;
 		public const byte			TypeReal64Array				= 107;
 		public const byte			TypeStringArray				= 108;
 		public const byte			TypeObjectArray				= 109;
+		public const byte			TypeBitArray				= 110;
 
 		public const byte			TypeCreate					= 201;
 		public const byte			TypeCallStaticMethod		= 202;
@@ -1775,6 +2591,13 @@ namespace bridge.server
 
 		public const byte			TypeTemplateReq				= 212;
 		public const byte			TypeTemplateReply			= 213;
+		public const byte			TypeReleaseBatch			= 214;
+		public const byte			TypePrepare					= 215;
+		public const byte			TypeInvoke					= 216;
+		public const byte			TypeCompression				= 217;
+		public const byte			TypeChain					= 218;
+		public const byte			TypeGetProperties			= 219;
+		public const byte			TypeProject					= 220;
 
 		#endregion
 
@@ -1793,11 +2616,12 @@ namespace bridge.server
 			_typemap[typeof(string)] = TypeString;
 			_typemap[typeof(object)] = TypeObject;
 
-			_typemap[typeof(bool[])] = TypeBoolArray;
+			_typemap[typeof(bool[])] = TypeBitArray;
+			_typemap[typeof(bool?[])] = TypeBitArray;
 			_typemap[typeof(byte[])] = TypeByteArray;
 			_typemap[typeof(int[])] = TypeInt32Array;
 			_typemap[typeof(long[])] = TypeInt64Array;
-			_typemap[typeof(float[])] = TypeReal64Array;
+			_typemap[typeof(float[])] = TypeFloat32Array;
 			_typemap[typeof(double[])] = TypeReal64Array;
 			_typemap[typeof(string[])] = TypeStringArray;
 			_typemap[typeof(object[])] = TypeObjectArray;
@@ -1814,6 +2638,9 @@ namespace bridge.server
 
 		// Variables
 
+		protected const int				BulkChunkSize = 64 * 1024;
+		protected const int				NullLength = -1;
+
 		protected byte					_type;
 		static Dictionary<Type,byte>	_typemap = new Dictionary<Type,byte>();
 	}
@@ -3425,9 +4252,7 @@ namespace bridge.server.data
 		{
 			base.Serialize (cout);
 			cout.WriteInt32 (Length);
-
-			for (int i = 0 ; i < Length ; i++)
-				cout.WriteByte (Value[i]);
+			cout.Write (Value, 0, Length);
 		}
 		
 		/// <summary>
@@ -3438,9 +4263,9 @@ namespace bridge.server.data
 		{
 			Length = cin.ReadInt32();
 			Value = new byte[Length];
-			 
-			for (int i = 0 ; i < Length ; i++)
-				Value[i] = (byte)cin.ReadByte();
+
+			if (cin.Read (Value, 0, Length) < Length)
+				throw new EndOfStreamException ("end of stream reached while reading array");
 		}
 
 	}
@@ -3837,9 +4662,7 @@ namespace bridge.server.data
 		{
 			base.Serialize (cout);
 			cout.WriteInt32 (Length);
-
-			for (int i = 0 ; i < Length ; i++)
-				cout.WriteInt64 (Value[i]);
+			WriteLongs (cout, Value, Length);
 		}
 		
 		/// <summary>
@@ -3849,10 +4672,7 @@ namespace bridge.server.data
 		public override void Deserialize (IBinaryReader cin)
 		{
 			Length = cin.ReadInt32();
-			Value = new long[Length];
-			 
-			for (int i = 0 ; i < Length ; i++)
-				Value[i] = cin.ReadInt64();
+			Value = ReadLongs (cin, Length);
 		}
 
 	}
@@ -4004,7 +4824,7 @@ namespace bridge.server.data
 				var indices = rindices.NameList;
 				cout.WriteInt32 (indices.Length);
 				for (int i = 0 ; i < indices.Length ; i++)
-					cout.WriteString (indices[i], Encoding.ASCII);
+					WriteStringOrNull (cout, indices[i]);
 			} else
 				cout.WriteInt32 (0);
 			
@@ -4013,16 +4833,24 @@ namespace bridge.server.data
 				var indices = cindices.NameList;
 				cout.WriteInt32 (indices.Length);
 				for (int i = 0 ; i < indices.Length ; i++)
-					cout.WriteString (indices[i], Encoding.ASCII);
+					WriteStringOrNull (cout, indices[i]);
 			} else
 				cout.WriteInt32 (0);
 
 			cout.WriteInt32 (Value.RowCount);
 			cout.WriteInt32 (Value.ColumnCount);
 
-			for (int ci = 0 ; ci < Value.ColumnCount ; ci++)
+			// dense storage is column-major, matching the wire format, so can be sent as a block
+			var dense = Value as DenseMatrix;
+			if (dense != null)
 			{
-				for (int ri = 0 ; ri < Value.RowCount ; ri++)
+				WriteDoubles (cout, dense.Values, Value.RowCount * Value.ColumnCount);
+				return;
+			}
+
+			for (int ci = 0 ; ci < Value.ColumnCount ; ci++)
+			{
+				for (int ri = 0 ; ri < Value.RowCount ; ri++)
 				{
 					cout.WriteDouble (Value[ri,ci]);
 				}
@@ -4045,7 +4873,7 @@ namespace bridge.server.data
 			{
 				rindex = new IndexByName<string> ();
 				for (int i = 0 ; i < ridxlen ; i++)
-					rindex.Add (cin.ReadString());
+					rindex.Add (ReadStringOrNull (cin));
 			}
 			
 			var cidxlen = cin.ReadInt32();
@@ -4053,20 +4881,14 @@ namespace bridge.server.data
 			{
 				cindex = new IndexByName<string> ();
 				for (int i = 0 ; i < cidxlen ; i++)
-					cindex.Add (cin.ReadString());
+					cindex.Add (ReadStringOrNull (cin));
 			}
 
 			var rows = cin.ReadInt32();
 			var cols = cin.ReadInt32();
-			Value = new IndexedMatrix (rows, cols, rindex, cindex);
 
-			for (int ci = 0 ; ci < Value.ColumnCount ; ci++)
-			{
-				for (int ri = 0 ; ri < Value.RowCount ; ri++)
-				{
-					Value[ri,ci] = cin.ReadDouble();
-				}
-			}
+			var data = ReadDoubles (cin, rows * cols);
+			Value = new IndexedMatrix (data, rows, cols, rindex, cindex);
 		}
 	}
 }
@@ -4526,7 +5348,7 @@ namespace bridge.server.data
 namespace bridge.server.data
 {
 	/// <summary>
-	/// CLR string array message.
+	/// CLR string array message (a null element, NA in R, is sent with length -1)
 	/// </summary>
 	public class CLRStringArrayMessage : CLRMessage
 	{
@@ -4564,7 +5386,7 @@ namespace bridge.server.data
 			cout.WriteInt32 (Length);
 
 			for (int i = 0 ; i < Length ; i++)
-				cout.WriteString (Value[i], Encoding.ASCII);
+				WriteStringOrNull (cout, Value[i]);
 		}
 		
 		/// <summary>
@@ -4577,7 +5399,7 @@ namespace bridge.server.data
 			Value = new string[Length];
 			 
 			for (int i = 0 ; i < Length ; i++)
-				Value[i] = cin.ReadString();
+				Value[i] = ReadStringOrNull (cin);
 		}
 
 	}
@@ -4644,7 +5466,7 @@ namespace bridge.server.data
 		public override void Serialize (IBinaryWriter cout)
 		{
 			base.Serialize (cout);
-			cout.WriteString (Value, Encoding.ASCII);
+			cout.WriteString (Value, Encoding.UTF8);
 		}
 		
 		/// <summary>
@@ -4653,7 +5475,7 @@ namespace bridge.server.data
 		/// <param name="cin">Cin.</param>
 		public override void Deserialize (IBinaryReader cin)
 		{
-			Value = cin.ReadString();
+			Value = cin.ReadString(Encoding.UTF8);
 		}
 
 	}
@@ -4727,11 +5549,19 @@ namespace bridge.server.data
 				var namelist = indices.NameList;
 				cout.WriteInt32 (namelist.Length);
 				for (int i = 0 ; i < namelist.Length ; i++)
-					cout.WriteString (namelist[i], Encoding.ASCII);
+					WriteStringOrNull (cout, namelist[i]);
 			} else
 				cout.WriteInt32 (0);
 
 			cout.WriteInt32 (Value.Count);
+
+			var dense = Value as DenseVector;
+			if (dense != null)
+			{
+				WriteDoubles (cout, dense.Values, Value.Count);
+				return;
+			}
+
 			for (int i = 0 ; i < Value.Count ; i++)
 				cout.WriteDouble (Value[i]);
 		}
@@ -4750,14 +5580,11 @@ namespace bridge.server.data
 			{
 				rindex = new IndexByName<string> ();
 				for (int i = 0 ; i < ridxlen ; i++)
-					rindex.Add (cin.ReadString());
+					rindex.Add (ReadStringOrNull (cin));
 			}
 
 			var count = cin.ReadInt32();
-			Value = new IndexedVector (count, rindex);
-
-			for (int i = 0 ; i < count ; i++)
-				Value[i] = cin.ReadDouble();
+			Value = new IndexedVector (ReadDoubles (cin, count), rindex);
 		}
 	}
 }
@@ -13081,21 +13908,17 @@ namespace bridge.math.matrix
 	{
 		public IndexByName (params T[] names)
 		{
-			int i = 0;
 			foreach (T item in names)
 			{
 				Add(item);
-				_ordering[item.ToString()] = i++;
 			}
 		}
 		
 		public IndexByName (IEnumerable<T> c)
 		{
-			int i = 0;
 			foreach (T item in c)
 			{
 				Add(item);
-				_ordering[item.ToString()] = i++;
 			}
 		}
 		
@@ -13122,7 +13945,7 @@ namespace bridge.math.matrix
 			{ 
 				string[] list = new string[Count];
 				for (int i = 0 ; i < Count ; i++)
-					list[i] = this[i].ToString();
+					list[i] = this[i] != null ? this[i].ToString() : null;
 				
 				return list;
 			} 
@@ -13142,8 +13965,9 @@ namespace bridge.math.matrix
 		{
 			base.Add (name);
 			
-			var key = name.ToString();
-			_ordering[key] = Count-1;
+			// unnamed (null) positions cannot be looked up
+			if (name != null)
+				_ordering[name.ToString()] = Count-1;
 		}
 
 		
@@ -13160,7 +13984,11 @@ namespace bridge.math.matrix
 			
 			int i = 0;
 			foreach (var o in this)
-				_ordering[o.ToString()] = i++; 
+			{
+				if (o != null)
+					_ordering[o.ToString()] = i;
+				i++;
+			}
 		}
 		
 		
@@ -17678,6 +18506,24 @@ namespace bridge.common.reflection
         }
 
 
+        /// <summary>
+        /// Invokes a resolved method, conforming the arguments to its parameter types if needed
+        /// </summary>
+        /// <param name='obj'>
+        /// Target object (or null for a static method)
+        /// </param>
+        /// <param name='method'>
+        /// Method.
+        /// </param>
+        /// <param name='parameters'>
+        /// Parameters.
+        /// </param>
+        public static object InvokeMethod(object obj, MethodInfo method, params object[] parameters)
+        {
+            return CallMethod(obj, method, parameters);
+        }
+
+
         /// <summary>
         /// Finds the matching or closest method
         /// </summary>
@@ -26960,3 +27806,2010 @@ namespace bridge.common.utils
 
 }
 
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/ctrl/CLRReleaseBatchMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR Release message for a batch of objects (sent by clients that coalesce releases).
+	/// </summary>
+	public class CLRReleaseBatchMessage : CLRMessage
+	{
+		public CLRReleaseBatchMessage ()
+			: base (TypeReleaseBatch)
+		{
+		}
+
+		public CLRReleaseBatchMessage (int[] objectIds)
+			: base (TypeReleaseBatch)
+		{
+			ObjectIds = objectIds;
+		}
+
+
+		// Properties
+
+		public int[] ObjectIds
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+
+			cout.WriteInt32 (ObjectIds.Length);
+			for (int i = 0 ; i < ObjectIds.Length ; i++)
+				cout.WriteInt32 (ObjectIds[i]);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			var len = cin.ReadInt32();
+			ObjectIds = new int[len];
+
+			for (int i = 0 ; i < len ; i++)
+				ObjectIds[i] = cin.ReadInt32();
+		}
+	}
+}
+
+// -------------------------------------------
+// File: ../DotNet/Library/src/common/io/UnixEndPoint.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.common.io
+{
+	/// <summary>
+	/// Endpoint for a unix domain (AF_UNIX) stream socket, addressed by filesystem path
+	/// </summary>
+	public class UnixEndPoint : EndPoint
+	{
+		public UnixEndPoint (string path)
+		{
+			if (string.IsNullOrEmpty (path))
+				throw new ArgumentException ("unix socket path must be provided");
+
+			Path = path;
+		}
+
+
+		// Properties
+
+		public string Path
+			{ get; private set; }
+
+		public override AddressFamily AddressFamily
+			{ get { return AddressFamily.Unix; } }
+
+
+		// Functions
+
+		/// <summary>
+		/// Create endpoint from socket address (sockaddr_un: family followed by a null terminated path)
+		/// </summary>
+		/// <param name="address">Address.</param>
+		public override EndPoint Create (SocketAddress address)
+		{
+			var len = address.Size - 2;
+			var bytes = new byte[len];
+			for (int i = 0 ; i < len ; i++)
+				bytes[i] = address[i + 2];
+
+			var end = Array.IndexOf (bytes, (byte)0);
+			var path = Encoding.UTF8.GetString (bytes, 0, end >= 0 ? end : len);
+
+			// unnamed (client side) sockets have no path
+			return path.Length > 0 ? new UnixEndPoint (path) : (EndPoint)new UnixEndPoint ("unnamed");
+		}
+
+
+		/// <summary>
+		/// Serialize endpoint into socket address
+		/// </summary>
+		public override SocketAddress Serialize ()
+		{
+			var bytes = Encoding.UTF8.GetBytes (Path);
+			var address = new SocketAddress (AddressFamily.Unix, 2 + bytes.Length + 1);
+			for (int i = 0 ; i < bytes.Length ; i++)
+				address[i + 2] = bytes[i];
+
+			address[2 + bytes.Length] = 0;
+			return address;
+		}
+
+
+		public override string ToString ()
+		{
+			return "unix://" + Path;
+		}
+
+		public override int GetHashCode ()
+		{
+			return Path.GetHashCode ();
+		}
+
+		public override bool Equals (object o)
+		{
+			var other = o as UnixEndPoint;
+			return other != null && other.Path == Path;
+		}
+	}
+}
+
+// -------------------------------------------
+// File: ../DotNet/Library/src/common/io/SharedMemoryStream.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.common.io
+{
+	/// <summary>
+	/// Server end of a shared memory transport, consisting of a pair of single-producer / single-consumer
+	/// ring buffers in a memory mapped file.  The layout (all little-endian) is:
+	/// <list type="bullet">
+	/// <item>[0,64): magic, version, ring capacity, connection state, server pid, client pid (int32 each)</item>
+	/// <item>[64,320): request head, request tail, reply head, reply tail (int64 each, one per cache line)</item>
+	/// <item>[4096, 4096 + capacity): request ring (client -> server)</item>
+	/// <item>[4096 + capacity, 4096 + 2*capacity): reply ring (server -> client)</item>
+	/// </list>
+	/// Head and tail are monotonically increasing byte counts, each written only by its owning side.  There is
+	/// no portable futex or eventfd on the CLR, so waiting spins, then yields, then sleeps.
+	/// </summary>
+	public unsafe class SharedMemoryStream : Stream
+	{
+		public SharedMemoryStream (string path, int capacity = DefaultCapacity)
+		{
+			if (capacity <= 0 || (capacity & (capacity - 1)) != 0)
+				throw new ArgumentException ("shared memory ring capacity must be a power of 2: " + capacity);
+
+			Path = path;
+			_capacity = capacity;
+			_mask = capacity - 1;
+
+			_file = MemoryMappedFile.CreateFromFile (path, FileMode.Create, null, HeaderSize + 2L * capacity);
+			_view = _file.CreateViewAccessor ();
+
+			byte* ptr = null;
+			_view.SafeMemoryMappedViewHandle.AcquirePointer (ref ptr);
+			_base = ptr + _view.PointerOffset;
+
+			*(int*)(_base + OffVersion) = Version;
+			*(int*)(_base + OffCapacity) = capacity;
+			*(int*)(_base + OffServerPid) = Process.GetCurrentProcess().Id;
+			Volatile.Write (ref *(int*)(_base + OffState), StateIdle);
+			Volatile.Write (ref *(int*)(_base + OffMagic), Magic);
+		}
+
+
+		// Constants
+
+		public const int			Magic				= 0x4d485344;
+		public const int			Version				= 1;
+		public const int			HeaderSize			= 4096;
+		public const int			DefaultCapacity		= 4 << 20;
+
+		public const int			StateIdle			= 0;
+		public const int			StateConnected		= 1;
+		public const int			StateClosed			= 2;
+		public const int			StateConnecting		= 3;
+
+
+		// Properties
+
+		public string Path
+			{ get; private set; }
+
+		public override bool CanRead
+			{ get { return true; } }
+
+		public override bool CanWrite
+			{ get { return true; } }
+
+		public override bool CanSeek
+			{ get { return false; } }
+
+		public override long Length
+			{ get { throw new ArgumentException ("cannot support seeking on shared memory stream"); } }
+
+		public override long Position
+		{ 
+			get { throw new ArgumentException ("cannot support seeking on shared memory stream"); } 
+			set { throw new ArgumentException ("cannot support seeking on shared memory stream"); } 
+		}
+
+
+		// Functions
+
+
+		/// <summary>
+		/// Determine whether a live server owns the shared memory file at the given path
+		/// </summary>
+		/// <param name="path">Path.</param>
+		public static bool IsServerAlive (string path)
+		{
+			if (!File.Exists (path))
+				return false;
+
+			try
+			{
+				using (var cin = new BinaryReader (new FileStream (path, FileMode.Open, FileAccess.Read, FileShare.ReadWrite)))
+				{
+					if (cin.ReadInt32 () != Magic)
+						return false;
+
+					cin.BaseStream.Seek (OffServerPid, SeekOrigin.Begin);
+					return IsProcessAlive (cin.ReadInt32 ());
+				}
+			}
+			catch (IOException)
+			{
+				return false;
+			}
+		}
+
+
+		/// <summary>
+		/// Wait for a client to attach to the rings
+		/// </summary>
+		public void Accept ()
+		{
+			while (Volatile.Read (ref *(int*)(_base + OffState)) != StateConnected)
+				Thread.Sleep (1);
+		}
+
+
+		/// <summary>
+		/// Make the rings available to the next client
+		/// </summary>
+		public void Disconnect ()
+		{
+			Volatile.Write (ref *(int*)(_base + OffState), StateIdle);
+		}
+
+
+		/// <summary>
+		/// Read available bytes from the request ring, waiting for at least 1 byte
+		/// </summary>
+		public override int Read (byte[] buffer, int offset, int count)
+		{
+			var phead = (long*)(_base + OffRequestHead);
+			var ptail = (long*)(_base + OffRequestTail);
+
+			long tail = *ptail;
+			long head = Volatile.Read (ref *phead);
+			for (int spins = 0 ; head == tail ; spins++)
+			{
+				if (!Pause (spins))
+					return 0;
+
+				head = Volatile.Read (ref *phead);
+			}
+
+			var n = (int)Math.Min (count, head - tail);
+			CopyFrom (_base + HeaderSize, tail, buffer, offset, n);
+
+			Volatile.Write (ref *ptail, tail + n);
+			return n;
+		}
+
+
+		/// <summary>
+		/// Reads a byte.
+		/// </summary>
+		public override int ReadByte ()
+		{
+			return Read (_byte, 0, 1) == 1 ? _byte[0] : -1;
+		}
+
+
+		/// <summary>
+		/// Write the buffer to the reply ring, waiting for space as needed
+		/// </summary>
+		public override void Write (byte[] buffer, int offset, int count)
+		{
+			var phead = (long*)(_base + OffReplyHead);
+			var ptail = (long*)(_base + OffReplyTail);
+
+			while (count > 0)
+			{
+				long head = *phead;
+				long free = _capacity - (head - Volatile.Read (ref *ptail));
+				for (int spins = 0 ; free == 0 ; spins++)
+				{
+					if (!Pause (spins))
+						throw new IOException ("shared memory client disconnected: " + Path);
+
+					free = _capacity - (head - Volatile.Read (ref *ptail));
+				}
+
+				var n = (int)Math.Min (count, free);
+				CopyTo (buffer, offset, _base + HeaderSize + _capacity, head, n);
+
+				Volatile.Write (ref *phead, head + n);
+				offset += n;
+				count -= n;
+			}
+		}
+
+
+		/// <summary>
+		/// Flush (writes are visible to the client as soon as they are made)
+		/// </summary>
+		public override void Flush ()
+		{
+		}
+
+
+		/// <summary>
+		/// Close the stream, removing the mapping
+		/// </summary>
+		public override void Close ()
+		{
+			if (_base == null)
+				return;
+
+			_view.SafeMemoryMappedViewHandle.ReleasePointer ();
+			_view.Dispose ();
+			_file.Dispose ();
+			_base = null;
+
+			File.Delete (Path);
+		}
+
+
+		public override long Seek (long offset, SeekOrigin origin)
+		{
+			throw new ArgumentException ("cannot support seeking on shared memory stream");
+		}
+
+		public override void SetLength (long value)
+		{
+			throw new ArgumentException ("cannot support seeking on shared memory stream");
+		}
+
+
+		#region Implementation
+
+
+		/// <summary>
+		/// Back off while waiting on the client, returning false if the client has gone away
+		/// </summary>
+		private bool Pause (int spins)
+		{
+			if (Volatile.Read (ref *(int*)(_base + OffState)) != StateConnected)
+				return false;
+
+			if (spins < SpinLimit)
+				Thread.SpinWait (20);
+			else if (spins < YieldLimit)
+				Thread.Yield ();
+			else
+			{
+				Thread.Sleep (1);
+				if ((spins - YieldLimit) % 1000 == 999 && !IsProcessAlive (*(int*)(_base + OffClientPid)))
+					return false;
+			}
+
+			return true;
+		}
+
+
+		/// <summary>
+		/// Copy from ring at given (unwrapped) position into the buffer
+		/// </summary>
+		private void CopyFrom (byte* ring, long pos, byte[] buffer, int offset, int count)
+		{
+			var start = (int)(pos & _mask);
+			var first = Math.Min (count, _capacity - start);
+
+			Marshal.Copy ((IntPtr)(ring + start), buffer, offset, first);
+			if (first < count)
+				Marshal.Copy ((IntPtr)ring, buffer, offset + first, count - first);
+		}
+
+
+		/// <summary>
+		/// Copy from buffer into ring at given (unwrapped) position
+		/// </summary>
+		private void CopyTo (byte[] buffer, int offset, byte* ring, long pos, int count)
+		{
+			var start = (int)(pos & _mask);
+			var first = Math.Min (count, _capacity - start);
+
+			Marshal.Copy (buffer, offset, (IntPtr)(ring + start), first);
+			if (first < count)
+				Marshal.Copy (buffer, offset + first, (IntPtr)ring, count - first);
+		}
+
+
+		private static bool IsProcessAlive (int pid)
+		{
+			try
+			{
+				return !Process.GetProcessById (pid).HasExited;
+			}
+			catch (ArgumentException)
+			{
+				return false;
+			}
+		}
+
+
+		#endregion
+
+		// Header layout
+
+		private const int			OffMagic			= 0;
+		private const int			OffVersion			= 4;
+		private const int			OffCapacity			= 8;
+		private const int			OffState			= 12;
+		private const int			OffServerPid		= 16;
+		private const int			OffClientPid		= 20;
+		private const int			OffRequestHead		= 64;
+		private const int			OffRequestTail		= 128;
+		private const int			OffReplyHead		= 192;
+		private const int			OffReplyTail		= 256;
+
+		private static readonly int	SpinLimit			= Environment.ProcessorCount > 1 ? 1000 : 0;
+		private static readonly int	YieldLimit			= SpinLimit + 5000;
+
+		// Variables
+
+		private MemoryMappedFile			_file;
+		private MemoryMappedViewAccessor	_view;
+		private byte*						_base;
+		private int							_capacity;
+		private long						_mask;
+		private byte[]						_byte = new byte[1];
+	}
+}
+
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/ctrl/CLRPrepareMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR Prepare message: resolves a method once, replying with a handle for use with CLRInvokeMessage
+	/// </summary>
+	public class CLRPrepareMessage : CLRMessage
+	{
+		public CLRPrepareMessage ()
+			: base (TypePrepare)
+		{
+		}
+
+		public CLRPrepareMessage (string classname, string method, string[] argtypes)
+			: base (TypePrepare)
+		{
+			ClassName = classname;
+			MethodName = method;
+			ArgTypes = argtypes;
+		}
+
+
+		// Properties
+
+		public string ClassName
+			{ get; private set; }
+
+		public string MethodName
+			{ get; private set; }
+
+		public string[] ArgTypes
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+
+			// class & method names
+			cout.WriteString (ClassName);
+			cout.WriteString (MethodName);
+
+			// argument types (-1 if not given)
+			cout.WriteInt32 (ArgTypes != null ? ArgTypes.Length : -1);
+			for (int i = 0 ; ArgTypes != null && i < ArgTypes.Length ; i++)
+				cout.WriteString (ArgTypes[i]);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			// class & method names
+			ClassName = cin.ReadString();
+			MethodName = cin.ReadString();
+
+			// argument types
+			var len = cin.ReadInt32 ();
+			if (len < 0)
+				return;
+
+			ArgTypes = new string[len];
+			for (int i = 0 ; i < len ; i++)
+				ArgTypes[i] = cin.ReadString();
+		}
+
+	}
+}
+
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/ctrl/CLRInvokeMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR Invoke message: calls a method prepared with CLRPrepareMessage
+	/// </summary>
+	public class CLRInvokeMessage : CLRMessage
+	{
+		public CLRInvokeMessage ()
+			: base (TypeInvoke)
+		{
+		}
+
+		public CLRInvokeMessage (int handle, params object[] args)
+			: base (TypeInvoke)
+		{
+			Handle = handle;
+			Parameters = args;
+		}
+
+
+		// Properties
+
+		public int Handle
+			{ get; private set; }
+
+		public object[] Parameters
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+			cout.WriteInt32 (Handle);
+
+			// arguments
+			cout.WriteUInt16 ((ushort)Parameters.Length);
+			for (int i = 0 ; i < Parameters.Length ; i++)
+				CLRMessage.SerializeValue (cout, Parameters[i]);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			Handle = cin.ReadInt32();
+
+			// arguments
+			var len = (int)cin.ReadUInt16 ();
+			Parameters = new object[len];
+
+			for (int i = 0 ; i < len ; i++)
+				Parameters[i] = CLRMessage.DeserializeValue (cin);
+		}
+
+	}
+}
+
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/data/CLRBitArrayMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.data
+{
+	/// <summary>
+	/// CLR packed logical array message.  Values are sent as a bitset (8 per byte, lsb first), followed
+	/// by a bitset marking NA entries when any are present.  Decodes to bool[], or bool?[] when NAs are present.
+	/// </summary>
+	public class CLRBitArrayMessage : CLRMessage
+	{
+		public CLRBitArrayMessage ()
+			: base (TypeBitArray)
+		{
+		}
+
+		public CLRBitArrayMessage (bool[] value, int len = -1)
+			: base (TypeBitArray)
+		{
+			Value = value;
+			Length = len >= 0 ? len : Value.Length;
+		}
+
+		public CLRBitArrayMessage (bool?[] value, int len = -1)
+			: base (TypeBitArray)
+		{
+			Nullable = value;
+			Length = len >= 0 ? len : Nullable.Length;
+		}
+
+
+		// Properties
+
+		public bool[] Value
+			{ get; private set; }
+
+		public bool?[] Nullable
+			{ get; private set; }
+
+		public int Length
+			{ get; set; }
+
+
+		// Functions
+
+		/// <summary>
+		/// Get the array value, as bool?[] if NAs were received, otherwise bool[]
+		/// </summary>
+		public object ToObject ()
+		{
+			if (Nullable != null)
+				return Nullable;
+			else
+				return Value;
+		}
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+			cout.WriteInt32 (Length);
+
+			var nbytes = (Length + 7) / 8;
+			var bits = new byte[nbytes];
+			var na = Nullable != null ? new byte[nbytes] : null;
+			var hasNA = Nullable != null ? Pack (Nullable, Length, bits, na) : Pack (Value, Length, bits);
+
+			cout.WriteByte (hasNA ? FlagNA : (byte)0);
+			cout.Write (bits, 0, nbytes);
+			if (hasNA)
+				cout.Write (na, 0, nbytes);
+		}
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			Length = cin.ReadInt32();
+			var flags = cin.ReadByte();
+
+			var nbytes = (Length + 7) / 8;
+			var bits = ReadBits (cin, nbytes);
+
+			if ((flags & FlagNA) != 0)
+			{
+				var na = ReadBits (cin, nbytes);
+				Nullable = new bool?[Length];
+				for (int i = 0 ; i < Length ; i++)
+				{
+					if ((na[i >> 3] & (1 << (i & 7))) == 0)
+						Nullable[i] = (bits[i >> 3] & (1 << (i & 7))) != 0;
+				}
+			}
+			else
+			{
+				Value = new bool[Length];
+				for (int i = 0, b = 0 ; i < Length ; i += 8, b++)
+				{
+					int v = bits[b];
+					int n = Math.Min (8, Length - i);
+					for (int k = 0 ; k < n ; k++)
+						Value[i + k] = ((v >> k) & 1) != 0;
+				}
+			}
+		}
+
+
+		// Implementation
+
+		private static byte[] ReadBits (IBinaryReader cin, int nbytes)
+		{
+			var bits = new byte[nbytes];
+			if (cin.Read (bits, 0, nbytes) < nbytes)
+				throw new EndOfStreamException ("end of stream reached while reading array");
+			return bits;
+		}
+
+		private static bool Pack (bool[] values, int len, byte[] bits)
+		{
+			for (int i = 0, b = 0 ; i < len ; i += 8, b++)
+			{
+				int v = 0;
+				int n = Math.Min (8, len - i);
+				for (int k = 0 ; k < n ; k++)
+				{
+					if (values[i + k])
+						v |= 1 << k;
+				}
+				bits[b] = (byte)v;
+			}
+
+			return false;
+		}
+
+		private static bool Pack (bool?[] values, int len, byte[] bits, byte[] na)
+		{
+			var hasNA = false;
+			for (int i = 0 ; i < len ; i++)
+			{
+				var mask = (byte)(1 << (i & 7));
+				if (!values[i].HasValue)
+				{
+					na[i >> 3] |= mask;
+					hasNA = true;
+				}
+				else if (values[i].Value)
+					bits[i >> 3] |= mask;
+			}
+
+			return hasNA;
+		}
+
+
+		// Variables
+
+		public const byte		FlagNA = 1;
+	}
+}
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/ctrl/CLRCompressionMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR compression message: compress values of at least the given size in either direction (0 to disable).
+	/// </summary>
+	public class CLRCompressionMessage : CLRMessage
+	{
+		public CLRCompressionMessage ()
+			: base (TypeCompression)
+		{
+		}
+
+		public CLRCompressionMessage (int threshold, byte codec = CLRCompressedMessage.CodecDeflate)
+			: base (TypeCompression)
+		{
+			Threshold = threshold;
+			Codec = codec;
+		}
+
+
+		// Properties
+
+		public int Threshold
+			{ get; private set; }
+
+		public byte Codec
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+			cout.WriteInt32 (Threshold);
+			cout.WriteByte (Codec);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			Threshold = cin.ReadInt32();
+			Codec = (byte)cin.ReadByte();
+		}
+	}
+}
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/data/CLRCompressedMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.data
+{
+	/// <summary>
+	/// CLR compressed value envelope, wrapping the complete message for an array or matrix value:
+	/// <para>
+	/// codec (byte), element width (byte), uncompressed length (int32), chunk size (int32), followed by
+	/// the compressed length (int32) and raw deflate data for each chunk.
+	/// </para>
+	/// The data is byte-shuffled by element width before compression (grouping the 1st byte of every element,
+	/// then the 2nd, ...).  Chunks are compressed independently, in parallel for large values.
+	/// </summary>
+	public class CLRCompressedMessage : CLRMessage
+	{
+		public CLRCompressedMessage ()
+			: base (TypeCompressed)
+		{
+		}
+
+		public CLRCompressedMessage (byte[] data, int len, int width)
+			: base (TypeCompressed)
+		{
+			Data = data;
+			Length = len;
+			Width = width;
+		}
+
+
+		// Properties
+
+		/// <summary>
+		/// Size from which values written by the current thread (serving a client) are compressed, or 0 if not compressing
+		/// </summary>
+		public static int Threshold
+			{ get { return _threshold; } set { _threshold = value; } }
+
+		public byte[] Data
+			{ get; private set; }
+
+		public int Length
+			{ get; private set; }
+
+		public int Width
+			{ get; private set; }
+
+		/// <summary>
+		/// Reader over the uncompressed message
+		/// </summary>
+		public IBinaryReader Reader
+			{ get { return EndianStreams.ReaderFor (new MemoryStream (Data, 0, Length), EndianStreams.Endian.Little); } }
+
+
+		// Functions
+
+		/// <summary>
+		/// Element width to shuffle by for a given message type, or 0 if the type is not compressed
+		/// </summary>
+		/// <param name="type">Message type.</param>
+		public static int WidthOf (byte type)
+		{
+			switch (type)
+			{
+				case TypeVector:
+				case TypeMatrix:
+				case TypeReal64Array:
+				case TypeInt64Array:
+					return 8;
+				case TypeInt32Array:
+				case TypeFloat32Array:
+					return 4;
+				case TypeBoolArray:
+				case TypeBitArray:
+				case TypeByteArray:
+				case TypeStringArray:
+					return 1;
+				default:
+					return 0;
+			}
+		}
+
+
+		/// <summary>
+		/// Write value message, in a compressed envelope if at least the threshold size
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		/// <param name="msg">Value message.</param>
+		public static void Write (IBinaryWriter cout, CLRMessage msg)
+		{
+			var buffer = new MemoryStream ();
+			var writer = EndianStreams.WriterFor (buffer, EndianStreams.Endian.Little);
+			msg.Serialize (writer);
+			writer.Flush ();
+
+			var len = (int)buffer.Length;
+			if (len < Threshold)
+				cout.Write (buffer.GetBuffer(), 0, len);
+			else
+				new CLRCompressedMessage (buffer.GetBuffer(), len, WidthOf (msg.MessageType)).Serialize (cout);
+		}
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			var data = Width > 1 ? Shuffle (Data, Length, Width) : Data;
+			var chunks = new byte[(Length + ChunkSize - 1) / ChunkSize][];
+			Parallel.For (0, chunks.Length, i => 
+				chunks[i] = Deflate (data, i * ChunkSize, Math.Min (ChunkSize, Length - i * ChunkSize)));
+
+			base.Serialize (cout);
+			cout.WriteByte (CodecDeflate);
+			cout.WriteByte ((byte)Width);
+			cout.WriteInt32 (Length);
+			cout.WriteInt32 (ChunkSize);
+			foreach (var chunk in chunks)
+			{
+				cout.WriteInt32 (chunk.Length);
+				cout.Write (chunk, 0, chunk.Length);
+			}
+		}
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			var codec = (byte)cin.ReadByte();
+			if (codec != CodecDeflate)
+				throw new ArgumentException ("unknown compression codec: " + codec);
+
+			Width = (byte)cin.ReadByte();
+			Length = cin.ReadInt32();
+			var chunksize = cin.ReadInt32();
+			if (Length < 0 || chunksize <= 0)
+				throw new ArgumentException ("bad compressed value envelope");
+
+			var chunks = new byte[(int)(((long)Length + chunksize - 1) / chunksize)][];
+			for (int i = 0 ; i < chunks.Length ; i++)
+			{
+				chunks[i] = new byte[cin.ReadInt32()];
+				if (cin.Read (chunks[i], 0, chunks[i].Length) < chunks[i].Length)
+					throw new EndOfStreamException ("end of stream reached while reading compressed value");
+			}
+
+			var data = new byte[Length];
+			Parallel.For (0, chunks.Length, i => 
+				Inflate (chunks[i], data, i * chunksize, Math.Min (chunksize, Length - i * chunksize)));
+
+			Data = Width > 1 ? Unshuffle (data, Length, Width) : data;
+		}
+
+
+		// Implementation
+
+		private static byte[] Deflate (byte[] data, int offset, int count)
+		{
+			using (var output = new MemoryStream ())
+			{
+				using (var deflater = new DeflateStream (output, CompressionLevel.Fastest, true))
+					deflater.Write (data, offset, count);
+				return output.ToArray();
+			}
+		}
+
+		private static void Inflate (byte[] chunk, byte[] data, int offset, int count)
+		{
+			using (var inflater = new DeflateStream (new MemoryStream (chunk), CompressionMode.Decompress))
+			{
+				var read = 0;
+				while (read < count)
+				{
+					var n = inflater.Read (data, offset + read, count - read);
+					if (n == 0)
+						throw new EndOfStreamException ("compressed value is truncated");
+					read += n;
+				}
+			}
+		}
+
+		private static byte[] Shuffle (byte[] src, int len, int width)
+		{
+			var dst = new byte[len];
+			var n = len / width;
+			for (int j = 0 ; j < width ; j++)
+			{
+				for (int i = 0 ; i < n ; i++)
+					dst[j * n + i] = src[i * width + j];
+			}
+
+			Buffer.BlockCopy (src, n * width, dst, n * width, len - n * width);
+			return dst;
+		}
+
+		private static byte[] Unshuffle (byte[] src, int len, int width)
+		{
+			var dst = new byte[len];
+			var n = len / width;
+			for (int j = 0 ; j < width ; j++)
+			{
+				for (int i = 0 ; i < n ; i++)
+					dst[i * width + j] = src[j * n + i];
+			}
+
+			Buffer.BlockCopy (src, n * width, dst, n * width, len - n * width);
+			return dst;
+		}
+
+
+		// Variables
+
+		public const byte		CodecDeflate = 1;
+		public const int		ChunkSize = 1 << 20;
+
+		[ThreadStatic]
+		private static int		_threshold;
+	}
+}
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/data/CLRFloat32ArrayMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.data
+{
+	/// <summary>
+	/// CLR float32 array message.
+	/// </summary>
+	public class CLRFloat32ArrayMessage : CLRMessage
+	{
+		public CLRFloat32ArrayMessage ()
+			: base (TypeFloat32Array)
+		{
+		}
+
+		public CLRFloat32ArrayMessage (float[] value, int len = -1)
+			: base (TypeFloat32Array)
+		{
+			Value = value;
+			Length = len >= 0 ? len : Value.Length;
+		}
+
+
+		// Properties
+
+		public float[] Value
+			{ get; private set; }
+
+		public int Length
+			{ get; set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+			cout.WriteInt32 (Length);
+			WriteFloats (cout, Value, Length);
+		}
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			Length = cin.ReadInt32();
+			Value = ReadFloats (cin, Length);
+		}
+
+	}
+}
+
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/ctrl/CLRChainMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR Chain message: a sequence of method calls and property or indexed gets, each applied to the result
+	/// of the previous, evaluated in one request with only the final value returned
+	/// </summary>
+	public class CLRChainMessage : CLRMessage
+	{
+		// step kinds
+		public const byte StepCall = 0;
+		public const byte StepGet = 1;
+		public const byte StepIndex = 2;
+
+		/// <summary>
+		/// A step of the chain
+		/// </summary>
+		public class Step
+		{
+			public Step (byte kind, string name, params object[] args)
+			{
+				Kind = kind;
+				Name = name;
+				Parameters = args;
+			}
+
+			public byte Kind
+				{ get; private set; }
+
+			public string Name
+				{ get; private set; }
+
+			public object[] Parameters
+				{ get; private set; }
+		}
+
+
+		public CLRChainMessage ()
+			: base (TypeChain)
+		{
+		}
+
+		public CLRChainMessage (object obj, params Step[] steps)
+			: base (TypeChain)
+		{
+			ClassName = "";
+			Obj = obj;
+			Steps = steps;
+		}
+
+		public CLRChainMessage (string classname, params Step[] steps)
+			: base (TypeChain)
+		{
+			ClassName = classname;
+			Steps = steps;
+		}
+
+
+		// Properties
+
+		/// <summary>
+		/// Class on which the first step is a static call or get (empty if starting from an object)
+		/// </summary>
+		public string ClassName
+			{ get; private set; }
+
+		public object Obj
+			{ get; private set; }
+
+		public Step[] Steps
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+
+			// starting class or object
+			cout.WriteString (ClassName);
+			CLRMessage.SerializeValue (cout, Obj);
+
+			// steps
+			cout.WriteUInt16 ((ushort)Steps.Length);
+			foreach (var step in Steps)
+			{
+				cout.WriteByte (step.Kind);
+				cout.WriteString (step.Name);
+
+				cout.WriteUInt16 ((ushort)step.Parameters.Length);
+				for (int i = 0 ; i < step.Parameters.Length ; i++)
+					CLRMessage.SerializeValue (cout, step.Parameters[i]);
+			}
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			// starting class or object
+			ClassName = cin.ReadString();
+			Obj = CLRMessage.DeserializeValue (cin);
+
+			// steps
+			var len = (int)cin.ReadUInt16 ();
+			Steps = new Step[len];
+
+			for (int i = 0 ; i < len ; i++)
+			{
+				var kind = (byte)cin.ReadByte ();
+				var name = cin.ReadString ();
+
+				var argc = (int)cin.ReadUInt16 ();
+				var args = new object[argc];
+				for (int j = 0 ; j < argc ; j++)
+					args[j] = CLRMessage.DeserializeValue (cin);
+
+				Steps[i] = new Step (kind, name, args);
+			}
+		}
+
+	}
+}
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/ctrl/CLRGetPropertiesMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR GetProperties message: several properties of an object, read in one request.
+	/// </summary>
+	public class CLRGetPropertiesMessage : CLRMessage
+	{
+		public CLRGetPropertiesMessage ()
+			: base (TypeGetProperties)
+		{
+		}
+
+		public CLRGetPropertiesMessage (object obj, params string[] properties)
+			: base (TypeGetProperties)
+		{
+			Obj = obj;
+			PropertyNames = properties;
+		}
+
+
+		// Properties
+
+		public object Obj
+			{ get; private set; }
+
+		public string[] PropertyNames
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+
+			// object & property names
+			cout.WriteInt32 (CLRObjectProxy.ProxyIdFor (Obj));
+			cout.WriteUInt16 ((ushort)PropertyNames.Length);
+			foreach (var name in PropertyNames)
+				cout.WriteString (name);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			// object & property names
+			Obj = CLRObjectProxy.Find (cin.ReadInt32(), proxyok: true);
+			var len = (int)cin.ReadUInt16 ();
+			PropertyNames = new string[len];
+			for (int i = 0 ; i < len ; i++)
+				PropertyNames[i] = cin.ReadString();
+		}
+
+	}
+}
+
+// -------------------------------------------
+// File: ../DotNet/Library/src/common/reflection/PropertyProjector.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+namespace bridge.common.reflection
+{
+	/// <summary>
+	/// Reads properties of each element of a collection into columns, one typed array per property, using
+	/// compiled getters cached by element type and property name
+	/// </summary>
+	public static class PropertyProjector
+	{
+		/// <summary>
+		/// Projects the named properties of the elements of the collection into columns.  Numeric properties
+		/// become int[], long[] or double[] columns, bools bool?[], strings and enums string[], and other
+		/// types object[].  Null elements (and nullable properties without a value) read as int.MinValue,
+		/// long.MinValue, NaN or null, according to the column type.  Elements of a collection of mixed types
+		/// are read through the common base type or, if the property is not declared there, through the
+		/// property on each element's own type.
+		/// </summary>
+		/// <param name="collection">Collection.</param>
+		/// <param name="properties">Property names.</param>
+		public static object[] Project (object collection, params string[] properties)
+		{
+			var enumerable = collection as IEnumerable;
+			if (enumerable == null || collection is string)
+				throw new ArgumentException ("Project: object is not a collection: " + (collection != null ? collection.GetType().ToString() : "null"));
+
+			var items = Snapshot (enumerable);
+			var type = ElementType (collection.GetType(), items);
+
+			var columns = new object[properties.Length];
+			for (int i = 0 ; i < properties.Length ; i++)
+			{
+				if (type == null)
+					columns[i] = new object[0];
+				else if (HasProperty (type, properties[i]))
+					columns[i] = AccessorFor (type, properties[i]).Column (items);
+				else
+					columns[i] = MixedColumn (items, properties[i]);
+			}
+
+			return columns;
+		}
+
+
+		#region Implementation
+
+
+		/// <summary>
+		/// Reads property across elements into a column
+		/// </summary>
+		private abstract class Accessor
+		{
+			public abstract Type ColumnType { get; }
+
+			public abstract object Value (object item);
+
+			public abstract Array Column (object[] items);
+		}
+
+
+		/// <summary>
+		/// Accessor with compiled getter yielding the column element type
+		/// </summary>
+		private class Accessor<T> : Accessor
+		{
+			public Accessor (Func<object,T> getter)
+			{
+				_getter = getter;
+			}
+
+			public override Type ColumnType
+				{ get { return typeof(T); } }
+
+			public override object Value (object item)
+			{
+				return _getter (item);
+			}
+
+			public override Array Column (object[] items)
+			{
+				var column = new T[items.Length];
+				for (int i = 0 ; i < items.Length ; i++)
+					column[i] = _getter (items[i]);
+
+				return column;
+			}
+
+			private Func<object,T>		_getter;
+		}
+
+
+		/// <summary>
+		/// Copy of the elements of the collection
+		/// </summary>
+		private static object[] Snapshot (IEnumerable collection)
+		{
+			var sized = collection as ICollection;
+			if (sized != null)
+			{
+				var items = new object[sized.Count];
+				sized.CopyTo (items, 0);
+				return items;
+			}
+
+			var list = new List<object>();
+			foreach (var item in collection)
+				list.Add (item);
+
+			return list.ToArray();
+		}
+
+
+		/// <summary>
+		/// Reads property of elements of differing types, with the accessor for each element's type, into a column
+		/// of the type common to their accessors (object[] if they differ)
+		/// </summary>
+		private static Array MixedColumn (object[] items, string name)
+		{
+			var accessors = new Accessor[items.Length];
+			Type ctype = null;
+			for (int i = 0 ; i < items.Length ; i++)
+			{
+				if (items[i] == null)
+					continue;
+
+				var accessor = accessors[i] = AccessorFor (items[i].GetType(), name);
+				if (ctype == null)
+					ctype = accessor.ColumnType;
+				else if (ctype != accessor.ColumnType)
+					ctype = typeof(object);
+			}
+
+			ctype = ctype ?? typeof(object);
+			var column = Array.CreateInstance (ctype, items.Length);
+			for (int i = 0 ; i < items.Length ; i++)
+				column.SetValue (accessors[i] != null ? accessors[i].Value (items[i]) : MissingOf (ctype), i);
+
+			return column;
+		}
+
+
+		/// <summary>
+		/// Element type of the collection, as declared (if IEnumerable&lt;T&gt; for T other than object), otherwise
+		/// the most derived type common to its elements (null if there are none)
+		/// </summary>
+		private static Type ElementType (Type ctype, object[] items)
+		{
+			foreach (var itype in ctype.GetInterfaces())
+			{
+				if (itype.IsGenericType && itype.GetGenericTypeDefinition() == typeof(IEnumerable<>))
+				{
+					var etype = itype.GetGenericArguments()[0];
+					if (etype != typeof(object))
+						return etype;
+				}
+			}
+
+			Type common = null;
+			foreach (var item in items)
+			{
+				if (item == null)
+					continue;
+				if (common == null)
+					common = item.GetType();
+
+				while (!common.IsInstanceOfType (item))
+					common = common.BaseType;
+			}
+
+			return common;
+		}
+
+
+		/// <summary>
+		/// Determine whether type has named (non-indexed) property
+		/// </summary>
+		private static bool HasProperty (Type type, string name)
+		{
+			var prop = type.GetProperty (name);
+			return prop != null && prop.GetIndexParameters().Length == 0;
+		}
+
+
+		/// <summary>
+		/// Accessor for property on type, created on first use
+		/// </summary>
+		private static Accessor AccessorFor (Type type, string name)
+		{
+			var key = Tuple.Create (type, name);
+
+			Accessor accessor = null;
+			if (!_accessors.TryGetValue (key, out accessor))
+				accessor = _accessors.GetOrAdd (key, CreateAccessor (type, name));
+
+			return accessor;
+		}
+
+
+		/// <summary>
+		/// Compiles getter for property on type, converting to the column element type
+		/// </summary>
+		private static Accessor CreateAccessor (Type type, string name)
+		{
+			var prop = type.GetProperty (name);
+			if (prop == null || prop.GetIndexParameters().Length > 0)
+				throw new ArgumentException ("Project: cannot find property " + name + " in " + type);
+
+			var ptype = prop.PropertyType;
+			var vtype = Nullable.GetUnderlyingType (ptype) ?? ptype;
+			var ctype = ColumnTypeOf (vtype);
+			var missing = Expression.Constant (MissingOf (ctype), ctype);
+
+			// missing if element is null, otherwise (for nullable properties) if no value
+			var obj = Expression.Parameter (typeof(object), "obj");
+			Expression value = Expression.Property (Expression.Convert (obj, type), prop);
+			if (vtype != ptype)
+			{
+				var held = Expression.Variable (ptype, "value");
+				value = Expression.Block (new [] { held },
+					Expression.Assign (held, value),
+					Expression.Condition (
+						Expression.Property (held, "HasValue"),
+						ToColumn (Expression.Property (held, "Value"), vtype, ctype),
+						missing));
+			}
+			else
+			{
+				value = ToColumn (value, vtype, ctype);
+			}
+
+			var body = Expression.Condition (Expression.Equal (obj, Expression.Constant (null)), missing, value);
+			var getter = Expression.Lambda (typeof(Func<,>).MakeGenericType (typeof(object), ctype), body, obj).Compile();
+
+			return (Accessor)Activator.CreateInstance (typeof(Accessor<>).MakeGenericType (ctype), getter);
+		}
+
+
+		/// <summary>
+		/// Converts property value to column element type
+		/// </summary>
+		private static Expression ToColumn (Expression value, Type vtype, Type ctype)
+		{
+			if (vtype == ctype)
+				return value;
+			if (vtype.IsEnum)
+				return Expression.Call (Expression.Convert (value, typeof(object)), typeof(object).GetMethod ("ToString"));
+			else
+				return Expression.Convert (value, ctype);
+		}
+
+
+		/// <summary>
+		/// Column element type for property value type
+		/// </summary>
+		private static Type ColumnTypeOf (Type vtype)
+		{
+			if (vtype.IsEnum)
+				return typeof(string);
+
+			Type ctype = null;
+			if (_columntypes.TryGetValue (vtype, out ctype))
+				return ctype;
+			else
+				return typeof(object);
+		}
+
+
+		/// <summary>
+		/// Value for a missing element or property value in column of the given type
+		/// </summary>
+		private static object MissingOf (Type ctype)
+		{
+			if (ctype == typeof(int))
+				return int.MinValue;
+			if (ctype == typeof(long))
+				return long.MinValue;
+			if (ctype == typeof(double))
+				return double.NaN;
+			else
+				return null;
+		}
+
+
+		#endregion
+
+		// Variables
+
+		static ConcurrentDictionary<Tuple<Type,string>,Accessor>	_accessors = new ConcurrentDictionary<Tuple<Type,string>,Accessor>();
+
+		static Dictionary<Type,Type>	_columntypes = new Dictionary<Type,Type>
+		{
+			{ typeof(bool), typeof(bool?) },
+			{ typeof(byte), typeof(int) },
+			{ typeof(sbyte), typeof(int) },
+			{ typeof(short), typeof(int) },
+			{ typeof(ushort), typeof(int) },
+			{ typeof(int), typeof(int) },
+			{ typeof(uint), typeof(long) },
+			{ typeof(long), typeof(long) },
+			{ typeof(float), typeof(double) },
+			{ typeof(double), typeof(double) },
+			{ typeof(decimal), typeof(double) },
+			{ typeof(string), typeof(string) }
+		};
+	}
+}
+// -------------------------------------------
+// File: ../DotNet/Library/src/bridge/server/ctrl/CLRProjectMessage.cs
+// -------------------------------------------
+﻿// 
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//      2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+
+namespace bridge.server.ctrl
+{
+	/// <summary>
+	/// CLR Project message: properties of each element of a collection, read into one column per property.
+	/// </summary>
+	public class CLRProjectMessage : CLRMessage
+	{
+		public CLRProjectMessage ()
+			: base (TypeProject)
+		{
+		}
+
+		public CLRProjectMessage (object collection, params string[] properties)
+			: base (TypeProject)
+		{
+			Obj = collection;
+			PropertyNames = properties;
+		}
+
+
+		// Properties
+
+		public object Obj
+			{ get; private set; }
+
+		public string[] PropertyNames
+			{ get; private set; }
+
+
+		// Serialization
+		
+		/// <summary>
+		/// Serialize the message.
+		/// </summary>
+		/// <param name="cout">Cout.</param>
+		public override void Serialize (IBinaryWriter cout)
+		{
+			base.Serialize (cout);
+
+			// collection & property names
+			cout.WriteInt32 (CLRObjectProxy.ProxyIdFor (Obj));
+			cout.WriteUInt16 ((ushort)PropertyNames.Length);
+			foreach (var name in PropertyNames)
+				cout.WriteString (name);
+		}
+
+		
+		/// <summary>
+		/// Deserialize the message (assumes magic & type already read in)
+		/// </summary>
+		/// <param name="cin">Cin.</param>
+		public override void Deserialize (IBinaryReader cin)
+		{
+			// collection & property names
+			Obj = CLRObjectProxy.Find (cin.ReadInt32(), proxyok: true);
+			var len = (int)cin.ReadUInt16 ();
+			PropertyNames = new string[len];
+			for (int i = 0 ; i < len ; i++)
+				PropertyNames[i] = cin.ReadString();
+		}
+
+	}
+}
+
@@ -30,17 +30,27 @@
 #endif
 
 #include <cstdlib>
+#include <algorithm>
+#include <sstream>
 #include "Common.hpp"
 #include "CLRApi.hpp"
 #include "CLRObjectRef.hpp"
+#include "Capture.hpp"
 
 #include "msgs/ctrl/CLRCreateObject.hpp"
 #include "msgs/ctrl/CLRCallStatic.hpp"
 #include "msgs/ctrl/CLRCallMethod.hpp"
 #include "msgs/ctrl/CLRSetProperty.hpp"
 #include "msgs/ctrl/CLRGetProperty.hpp"
+#include "msgs/ctrl/CLRGetProperties.hpp"
+#include "msgs/ctrl/CLRProject.hpp"
 #include "msgs/ctrl/CLRGetIndexed.hpp"
 #include "msgs/ctrl/CLRRelease.hpp"
+#include "msgs/ctrl/CLRReleaseBatch.hpp"
+#include "msgs/ctrl/CLRPrepare.hpp"
+#include "msgs/ctrl/CLRInvoke.hpp"
+#include "msgs/ctrl/CLRCompression.hpp"
+#include "msgs/ctrl/CLRChain.hpp"
 
 using namespace std;
 using namespace Rcpp;
@@ -57,57 +67,74 @@ static void sleep_for (unsigned int seconds)
 }
 
 
-// get object ID from R object structure
-static int objectRefFor (SEXP obj)
-{
-    RObject robj (obj);
-    SEXP objid = robj.attr("ObjectId");
-    
-    if (!Rf_isNull(objid))
-        return Rcpp::as<int>(objid);
-    else
-        throw std::runtime_error ("CLRObject: cannot find object handle");
-}
-
 // evaluate query against CLR
 RValue CLRApi::query (CLRMessage* msg)
 {
     // make sure API has been started 
     start();
 
+    // pipelined: reply is collected when the batch completes
+    if (_batching)
+    {
+        enqueue (msg);
+	return RValue (R_NilValue);
+    }
+
     CLRMessage* rmsg = nullptr;
+    SEXP value = NULL;
+    CLRStats::Sample sample (msg->type(), msg->name());
     try
     {
       // send query
+      send_releases();
+      uint64_t sent = _sout->bytes();
+      uint64_t received = _sin->bytes();
+
+      sample.restart();
       msg->serialize (*_sout);
+      sample.lap (CLRStats::Serialize);
       _sout->flush();
 
-      // wait for response
-      short magic = _sin->read_int16();
-      if (magic != CLRMessage::Magic)
-	throw std::runtime_error ("message magic # is wrong, garbled sequence");
-    
-      char mtype = _sin->read_byte();
-      // create appropriate message container
-      rmsg = _factory->messageById (mtype);
-      // read message
-      rmsg->deserialize (*_sin);
+      // wait for response and read it
+      rmsg = read (&sample, &value);
+      sample.sent = _sout->bytes() - sent;
+      sample.received = _sin->bytes() - received;
     }
     catch (std::exception& se)
     {
         reset(true);
 	throw std::runtime_error(se.what());
     }
-    
-    // return SEXP
-    RValue v = rmsg->rvalue();
-    delete rmsg;
 
-    return v;
+    // value decoded directly
+    if (rmsg == nullptr)
+    {
+        RValue v (value);
+	sample.lap (CLRStats::Wrap);
+	_stats.record (sample);
+	return v;
+    }
+    
+    // return SEXP (the conversion raises if the reply is an exception)
+    try
+    {
+        RValue v = rmsg->rvalue();
+	sample.lap (CLRStats::Wrap);
+	_stats.record (sample);
+	delete rmsg;
+	return v;
+    }
+    catch (...)
+    {
+	sample.lap (CLRStats::Wrap);
+	_stats.record (sample);
+	delete rmsg;
+	throw;
+    }
 }
 
 // read message
-CLRMessage* CLRApi::read ()
+CLRMessage* CLRApi::read (CLRStats::Sample* sample, SEXP* value, char* rtype)
 {
     // wait for response
     short magic = _sin->read_int16();
@@ -115,10 +142,32 @@ CLRMessage* CLRApi::read ()
         throw std::runtime_error ("message magic # is wrong, garbled sequence");
     
     char mtype = _sin->read_byte();
+    if (rtype != nullptr)
+        *rtype = mtype;
+    if (sample != nullptr)
+        sample->lap (CLRStats::Wait);
+
+    // scalar and array values decode straight to SEXP
+    if (value != nullptr && (*value = _factory->valueById (mtype, *_sin)) != NULL)
+    {
+        if (sample != nullptr)
+	    sample->lap (CLRStats::Deserialize);
+	return nullptr;
+    }
+
     // create appropriate message container
     CLRMessage* msg = _factory->messageById (mtype);
     // read message
     msg->deserialize (*_sin);
+    if (sample != nullptr)
+        sample->lap (CLRStats::Deserialize);
+
+    // compressed envelope: read the value it carries in its place
+    if (mtype == CLRMessage::TypeCompressed)
+    {
+        delete msg;
+	return read (sample, value);
+    }
     
     return msg;
 }
@@ -130,34 +179,218 @@ void CLRApi::exec (CLRMessage* msg)
     // make sure API has been started 
     start();
     
+    CLRStats::Sample sample (msg->type(), msg->name());
     try
     {
         // send query
+        send_releases();
+        uint64_t sent = _sout->bytes();
+
+	sample.restart();
         msg->serialize (*_sout);
+	sample.lap (CLRStats::Serialize);
         _sout->flush();
+	sample.lap (CLRStats::Wait);
+	sample.sent = _sout->bytes() - sent;
     }
     catch (std::exception& se)
     {
         reset(false);
 	throw std::runtime_error(se.what());
     }
+
+    _stats.record (sample);
+}
+
+
+// queue request as part of batch
+void CLRApi::enqueue (CLRMessage* msg)
+{
+    CLRStats::Sample sample (msg->type(), msg->name());
+    try
+    {
+        send_releases();
+        uint64_t sent = _sout->bytes();
+
+	sample.restart();
+        msg->serialize (*_sout);
+	sample.lap (CLRStats::Serialize);
+	sample.sent = _sout->bytes() - sent;
+    }
+    catch (std::exception& se)
+    {
+        _batching = false;
+	_pending = 0;
+	_replies.clear();
+	_inflight.clear();
+        reset(true);
+	throw std::runtime_error(se.what());
+    }
+
+    // reply phases are recorded when the reply is read in drain()
+    _inflight.push_back (sample);
+
+    // bound the # of requests in flight so neither side blocks on a full socket
+    if (++_pending >= BatchWindow)
+        drain();
+}
+
+
+// write queued releases ahead of the next request (flushed along with it)
+void CLRApi::send_releases ()
+{
+    if (_released.empty())
+        return;
+
+    CLRReleaseBatch req (this, _released);
+    CLRStats::Sample sample (req.type(), req.name());
+    uint64_t sent = _sout->bytes();
+
+    req.serialize (*_sout);
+    for (size_t i = 0 ; i < _released.size() ; i++)
+        _handles.erase (_released[i]);
+    _released.clear();
+    _releases_due = false;
+
+    sample.lap (CLRStats::Serialize);
+    sample.sent = _sout->bytes() - sent;
+    _stats.record (sample);
+}
+
+
+// flush queued requests and read their replies
+void CLRApi::drain ()
+{
+    try
+    {
+        size_t next = 0;
+	if (!_inflight.empty())
+	    _inflight[0].restart();
+
+	// releases queued while the batch was written
+	if (_releases_due)
+	    send_releases();
+        _sout->flush();
+	for ( ; _pending > 0 ; _pending--, next++)
+	{
+	    // each reply's wait is measured from the end of the previous one
+	    CLRStats::Sample& sample = _inflight[next];
+	    if (next > 0)
+	        sample.restart();
+
+	    uint64_t received = _sin->bytes();
+	    SEXP value = NULL;
+	    CLRMessage* rmsg = read (&sample, &value);
+	    sample.received = _sin->bytes() - received;
+	    try
+	    {
+	        _replies.push_back (RObject(rmsg == nullptr ? value : (SEXP)rmsg->rvalue()));
+	    }
+	    catch (std::exception& e)
+	    {
+	        // remember first failure, but keep reading to stay in sync with the stream
+	        if (_batch_error.empty())
+		{
+		    std::stringstream ss;
+		    ss << "batch request " << (_replies.size()+1) << ": " << e.what();
+		    _batch_error = ss.str();
+		}
+	        _replies.push_back (RObject(R_NilValue));
+	    }
+	    delete rmsg;
+
+	    sample.lap (CLRStats::Wrap);
+	    _stats.record (sample);
+	}
+	_inflight.clear();
+    }
+    catch (std::exception& se)
+    {
+        _batching = false;
+	_pending = 0;
+	_replies.clear();
+	_inflight.clear();
+	_batch_error.clear();
+        reset(true);
+	throw std::runtime_error(se.what());
+    }
+}
+
+
+// start pipelining requests
+void CLRApi::begin_batch ()
+{
+    if (_batching)
+        throw std::runtime_error ("CLRApi: batch already in progress");
+
+    start();
+    _batching = true;
+    _pending = 0;
+    _replies.clear();
+    _inflight.clear();
+    _batch_error.clear();
+}
+
+
+// send any pending requests and return all replies
+List CLRApi::end_batch ()
+{
+    if (!_batching)
+        throw std::runtime_error ("CLRApi: no batch in progress");
+
+    drain();
+    _batching = false;
+
+    List replies (_replies.size());
+    for (size_t i = 0 ; i < _replies.size() ; i++)
+        replies[i] = _replies[i];
+
+    _replies.clear();
+    if (!_batch_error.empty())
+    {
+        std::string error = _batch_error;
+	_batch_error.clear();
+	throw std::runtime_error (error);
+    }
+
+    return replies;
+}
+
+
+// abandon batch, discarding replies
+void CLRApi::abort_batch ()
+{
+    if (!_batching)
+        return;
+
+    drain();
+    _batching = false;
+    _replies.clear();
+    _batch_error.clear();
 }
 
 
 // start connection with CLR
 void CLRApi::start()
 {
-    if (_tcp != nullptr)
+    check_fork();
+    if (_transport != nullptr)
       return;
     
     for (int i = 0 ; i <= _retries; i++)
     {
         try
         {
-	    _tcp = new RTcpClient (_host, _port);
-	    _sin = new BufferedSocketReader (_tcp);
-	    _sout = new BufferedSocketWriter (_tcp);
-	    return;
+	    _transport = RTransport::open (_host, _port, _options);
+	    if (!_capture.empty())
+	    {
+	        // later connections append to the same capture
+	        _transport = new RCaptureTransport (_transport, _capture, _captured);
+		_captured = true;
+	    }
+	    _sin = new BufferedSocketReader (_transport);
+	    _sout = new BufferedSocketWriter (_transport);
+	    break;
         }
         catch (...)
         {
@@ -167,17 +400,171 @@ void CLRApi::start()
 	        throw std::runtime_error("could not connect to CLR server");
         }
     }
+
+    // new connection: the server starts without compression
+    if (_compression > 0)
+        negotiate();
+}
+
+
+// drop state inherited from the parent process if running in a forked child
+//
+//  The child must not write to the parent's connection, so it lets go of the inherited transport
+//  (without closing the connection) and opens its own on the next request.  Object ids are global
+//  on the server, so references inherited from the parent remain usable from the child.  Releases
+//  queued by the parent are left to the parent, and the parent's handle table is dropped: inherited
+//  handles are not released by the child, so their entries would outlive them once collected there.
+//
+//  The server keeps one id per object, without counting holders, so the child also never releases
+//  the objects the parent held at the fork, even through handles of its own (as when it is sent one
+//  of them again).  Objects the parent obtains after the fork are not known to the child.
+//
+//  A shared memory server serves one session, held by the parent, so the child has no connection of
+//  its own to open: every request from the child raises an error instead.
+void CLRApi::check_fork ()
+{
+    int pid = process_id();
+    if (pid == _pid)
+        return;
+
+    if (RTransport::is_shm (_host))
+        throw std::runtime_error ("shm:// connections cannot be used from forked processes (connect with a tcp or unix:// endpoint to use forked workers)");
+
+    _pid = pid;
+    if (_transport != nullptr)
+        _transport->abandon();
+
+    delete _transport;
+    delete _sin;
+    delete _sout;
+    _transport = NULL;
+    _sin = NULL;
+    _sout = NULL;
+
+    for (HandleMap::iterator it = _handles.begin() ; it != _handles.end() ; ++it)
+        _inherited.insert (it->first);
+
+    _released.clear();
+    _releases_due = false;
+    _handles.clear();
+    _batching = false;
+    _pending = 0;
+    _replies.clear();
+    _inflight.clear();
+    _batch_error.clear();
+    _stats.reset();
+
+    // each process captures to its own file
+    if (!_capture.empty())
+    {
+        std::stringstream path;
+	path << _capture << "." << pid;
+	capture (path.str());
+    }
+}
+
+
+// compress values of at least threshold bytes in either direction (0 to disable)
+void CLRApi::compress (int threshold)
+{
+    if (_batching)
+        throw std::runtime_error ("cannot change compression within a batch");
+
+    check_fork();
+    _compression = max (threshold, 0);
+    if (_transport == nullptr)
+        start();
+    else
+        negotiate();
+}
+
+
+// send compression setting to the server
+void CLRApi::negotiate ()
+{
+    CLRMessage* reply = nullptr;
+    try
+    {
+        CLRCompression req (this, _compression);
+	send_releases();
+	req.serialize (*_sout);
+	_sout->flush();
+
+	// null reply, or exception if the server does not support compression
+	reply = read();
+	reply->rvalue();
+	delete reply;
+    }
+    catch (std::exception& e)
+    {
+        delete reply;
+        _compression = 0;
+	throw std::runtime_error (std::string("could not enable compression: ") + e.what());
+    }
+}
+
+
+// record traffic to capture file from the next connection on
+void CLRApi::capture (const std::string& path)
+{
+    _capture = path;
+    _captured = false;
+}
+
+
+// use given transport in place of connecting to the CLR
+void CLRApi::attach (RTransport* transport)
+{
+    reset(false);
+    _transport = transport;
+    _sin = new BufferedSocketReader (_transport);
+    _sout = new BufferedSocketWriter (_transport);
+}
+
+
+// decode all replies on the transport, returning decode statistics
+List CLRApi::replay ()
+{
+    start();
+    _stats.reset();
+
+    while (!_sin->isEOF())
+    {
+        CLRStats::Sample sample (0, std::string());
+	uint64_t received = _sin->bytes();
+
+	SEXP value = NULL;
+	char rtype = 0;
+	CLRMessage* rmsg = read (&sample, &value, &rtype);
+	sample.type = rtype;
+	sample.received = _sin->bytes() - received;
+	try
+	{
+	    if (rmsg != nullptr)
+	        RObject value (rmsg->rvalue());
+	}
+	catch (std::exception&)
+	{
+	    // exception replies raise on conversion
+	}
+	delete rmsg;
+
+	sample.lap (CLRStats::Wrap);
+	_stats.record (sample);
+    }
+
+    return _stats.frame();
 }
 
 
 // stop / close connection with CLR
 void CLRApi::reset(bool restart)
 {
-    if (_tcp != nullptr)
-        _tcp->close();
+    if (_transport != nullptr)
+        _transport->close();
     
-    if (_tcp != nullptr)
-        delete _tcp;
+    if (_transport != nullptr)
+        delete _transport;
 
     if (_sin != nullptr)
         delete _sin;
@@ -185,7 +572,7 @@ void CLRApi::reset(bool restart)
     if (_sout != nullptr)
         delete _sout;
     
-    _tcp = NULL;
+    _transport = NULL;
     _sin = NULL;
     _sout = NULL;
     
@@ -210,7 +597,7 @@ RValue CLRApi::callstatic (const std::string& classname, const std::string& meth
 // call method on object
 RValue CLRApi::call (CLRObject obj, const std::string& method, const List& argv)
 {
-    int objectId = objectRefFor (obj);
+    int objectId = CLRObjectRef::objectIdOf (obj);
     CLRCallMethod req (this, objectId, method, argv);
     return query (&req);
 }
@@ -218,15 +605,53 @@ RValue CLRApi::call (CLRObject obj, const std::string& method, const List& argv)
 // get property value
 RValue CLRApi::get (CLRObject obj, const std::string& property)
 {
-    int objectId = objectRefFor (obj);
+    int objectId = CLRObjectRef::objectIdOf (obj);
     CLRGetProperty req (this, objectId, property);
     return query (&req);
 }
 
+// get several property values, named by property
+RValue CLRApi::get_many (CLRObject obj, const CharacterVector& properties)
+{
+    int objectId = CLRObjectRef::objectIdOf (obj);
+    CLRGetProperties req (this, objectId, properties);
+    RValue values = query (&req);
+
+    // values arrive as an object array (not yet available when batching)
+    SEXP list = values;
+    if (TYPEOF(list) == VECSXP && Rf_length(list) == properties.size())
+        Rf_setAttrib (list, R_NamesSymbol, properties);
+    return values;
+}
+
+// get properties of each element of a collection, as a data.frame
+RValue CLRApi::project (CLRObject collection, const CharacterVector& properties)
+{
+    int objectId = CLRObjectRef::objectIdOf (collection);
+    CLRProject req (this, objectId, properties);
+    RValue columns = query (&req);
+
+    // columns arrive as an object array (not yet available when batching)
+    SEXP frame = columns;
+    if (TYPEOF(frame) != VECSXP || Rf_length(frame) != properties.size())
+        return columns;
+
+    int nrows = Rf_length(frame) > 0 ? Rf_length(VECTOR_ELT (frame, 0)) : 0;
+    Rcpp::Shield<SEXP> rownames (Rf_allocVector (INTSXP, 2));
+    INTEGER(rownames)[0] = NA_INTEGER;
+    INTEGER(rownames)[1] = -nrows;
+    Rcpp::Shield<SEXP> klass (Rf_mkString ("data.frame"));
+
+    Rf_setAttrib (frame, R_NamesSymbol, properties);
+    Rf_setAttrib (frame, R_RowNamesSymbol, rownames);
+    Rf_setAttrib (frame, R_ClassSymbol, klass);
+    return columns;
+}
+
 // get indexed value
 RValue CLRApi::get_indexed (CLRObject obj, int ith)
 {
-    int objectId = objectRefFor (obj);
+    int objectId = CLRObjectRef::objectIdOf (obj);
     CLRGetIndexed req (this, objectId, ith);
     return query (&req);
 }
@@ -234,14 +659,95 @@ RValue CLRApi::get_indexed (CLRObject obj, int ith)
 // set property value
 void CLRApi::set (CLRObject obj, const std::string& property, const RObject& value)
 {
-    int objectId = objectRefFor (obj);
+    int objectId = CLRObjectRef::objectIdOf (obj);
     CLRSetProperty req (this, objectId, property, value);
     query (&req);
 }
 
+// resolve method once, returning handle
+RValue CLRApi::prepare (const std::string& classname, const std::string& method, SEXP argtypes)
+{
+    CLRPrepare req (this, classname, method, argtypes);
+    return query (&req);
+}
+
+// invoke prepared method
+RValue CLRApi::invoke (int handle, const List& argv)
+{
+    CLRInvoke req (this, handle, argv);
+    return query (&req);
+}
+
+// evaluate chain of calls and gets, starting from an object or (given its name) a class
+RValue CLRApi::chain (SEXP target, const IntegerVector& kinds, const CharacterVector& names, const List& argv)
+{
+    if (kinds.size() != names.size() || kinds.size() != argv.size())
+        throw std::runtime_error ("CLRApi: chain step kinds, names and arguments differ in length");
+
+    if (TYPEOF(target) == STRSXP)
+    {
+        CLRChain req (this, Rcpp::as<std::string>(target), R_NilValue, kinds, names, argv);
+	return query (&req);
+    }
+
+    CLRObjectRef::objectIdOf (target);
+    CLRChain req (this, std::string(), target, kinds, names, argv);
+    return query (&req);
+}
+
 // release object
+//
+//  Called from the GC finalizer, which may run during any allocation, including part way through
+//  writing a request: the release is only queued (never written or flushed here, nor throwing), and
+//  sent ahead of the next request, or when a batch is drained once the queue has grown large.
 void CLRApi::release (int objectId)
 {
-    CLRRelease req (this, objectId);
-    exec (&req);
+    // held by the parent process
+    if (_inherited.count (objectId) > 0)
+    {
+        _handles.erase (objectId);
+	return;
+    }
+
+    try
+    {
+        _released.push_back (objectId);
+	_handles[objectId] = R_NilValue;
+    }
+    catch (...)
+    {
+        // out of memory: the object stays alive on the server
+	return;
+    }
+
+    if ((int)_released.size() >= ReleaseThreshold)
+        _releases_due = true;
+}
+
+// live R handle for object, or NULL if none
+//
+//  An object returned again after its handle was collected, but before the release was sent, keeps
+//  its id on the server: the queued release is withdrawn and a new handle created by the caller.
+SEXP CLRApi::handle (int objectId)
+{
+    HandleMap::iterator it = _handles.find (objectId);
+    if (it == _handles.end())
+        return NULL;
+
+    // release queued
+    if (it->second == R_NilValue)
+    {
+        _released.erase (std::remove (_released.begin(), _released.end(), objectId), _released.end());
+	_handles.erase (it);
+	return NULL;
+    }
+
+    SEXP handle = R_WeakRefKey (it->second);
+    return handle == R_NilValue ? NULL : handle;
+}
+
+// record weak reference to the R handle for object
+void CLRApi::track (int objectId, SEXP ref)
+{
+    _handles[objectId] = ref;
 }
@@ -25,10 +25,15 @@
 #define CLR_API
 
 #include <cstdlib>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
 #include "CLRFactory.hpp"
 #include "CLRObjectRef.hpp"
+#include "CLRStats.hpp"
+#include "OS.hpp"
 #include "msgs/CLRMessage.hpp"
-#include "TcpClient.hpp"
+#include "Transport.hpp"
 #include "io/BufferedSocketReader.hpp"
 #include "io/BufferedSocketWriter.hpp"
 
@@ -43,10 +48,16 @@ class CLRApi
   public:
 
     typedef SEXP CLRObject;
+    typedef std::unordered_map<int32_t,SEXP> HandleMap;
 
-    CLRApi (const char* host = "localhost", int port = 56789, int retries = 4)
-      : _host(host), _port(port), _retries(retries), _factory(new CLRFactory(this)), 
-	_tcp(NULL), _sin(NULL), _sout(NULL) {}
+    // maximum # of pipelined requests in flight before replies are drained
+    static const int BatchWindow = 256;
+    // # of queued releases from which a release batch is sent at the next safe point, even within a batch
+    static const int ReleaseThreshold = 4096;
+
+    CLRApi (const char* host = "localhost", int port = 56789, int retries = 4, const RSocketOptions& options = RSocketOptions())
+      : _host(host), _port(port), _retries(retries), _options(options), _captured(false), _factory(new CLRFactory(this)), 
+	_transport(NULL), _sin(NULL), _sout(NULL), _pid(process_id()), _compression(0), _batching(false), _pending(0), _releases_due(false) {}
 
     ~CLRApi()
     {
@@ -56,8 +67,8 @@ class CLRApi
 	    { _sout->close(); delete _sout; }
         if (_sin != NULL)
 	    { _sin->close(); delete _sin; }
-        if (_tcp != NULL)
-	    { _tcp->close(); delete _tcp; }
+        if (_transport != NULL)
+	    { _transport->close(); delete _transport; }
     }
 
     // message factory for this API 
@@ -65,7 +76,26 @@ class CLRApi
     {
         return _factory;
     }
+
+    // request statistics for this API
+    CLRStats& stats()
+    {
+        return _stats;
+    }
+
+    // size in bytes from which values are compressed (0 if not compressing)
+    int compression() const
+    {
+        return _compression;
+    }
   
+    // record traffic to capture file from the next connection on
+    void capture (const std::string& path);
+    // use given transport in place of connecting to the CLR (takes ownership)
+    void attach (RTransport* transport);
+    // compress values of at least threshold bytes in either direction (0 to disable), agreeing this with the server
+    void compress (int threshold);
+
     // start connection with CLR
     void start();
     // stop / close connection with CLR, resetting for new connection
@@ -80,15 +110,42 @@ class CLRApi
     RValue call (CLRObject obj, const std::string& method, const List& argv);
     // get property value
     RValue get (CLRObject obj, const std::string& property);
+    // get several property values in one request, as a list named by property
+    RValue get_many (CLRObject obj, const CharacterVector& properties);
+    // get properties of each element of a collection in one request, as a data.frame with a column per property
+    RValue project (CLRObject collection, const CharacterVector& properties);
     // set property value
     void set (CLRObject obj, const std::string& property, const RObject& value);
     // get indexed value
     RValue get_indexed (CLRObject obj, int ith);
 
-    // release object
+    // resolve method once, returning handle
+    RValue prepare (const std::string& classname, const std::string& method, SEXP argtypes);
+    // invoke prepared method (first argument is the object for instance methods)
+    RValue invoke (int handle, const List& argv);
+    // evaluate chain of calls and gets on the object (or class, if given a class name), returning the final value
+    RValue chain (SEXP target, const IntegerVector& kinds, const CharacterVector& names, const List& argv);
+
+    // release object (queued, sent with next request)
     void release (int objectId);
-    // evaluate query against CLR
-    CLRMessage* read ();
+
+    // live R handle for object, or NULL if none (taking back a release of the object not yet sent)
+    SEXP handle (int objectId);
+    // record weak reference to the R handle for object
+    void track (int objectId, SEXP ref);
+
+    // start pipelining requests: replies are collected until end_batch()
+    void begin_batch ();
+    // send any pending requests and return all replies (in order of request)
+    List end_batch ();
+    // abandon batch, discarding replies
+    void abort_batch ();
+    // read reply from CLR, timing its phases into sample if given; where value is given, scalar and array
+    // replies are decoded directly into it (unprotected) and NULL returned in place of a message; where
+    // rtype is given, it receives the type of the (outermost) reply message
+    CLRMessage* read (CLRStats::Sample* sample = nullptr, SEXP* value = nullptr, char* rtype = nullptr);
+    // decode all replies on the (attached) transport, returning decode statistics
+    List replay ();
 
   protected:
 
@@ -96,15 +153,43 @@ class CLRApi
     RValue query (CLRMessage* msg);
     // evaluate message on CLR
     void exec (CLRMessage* msg);
+    // queue request as part of batch
+    void enqueue (CLRMessage* msg);
+    // flush queued requests and read their replies
+    void drain ();
+    // write queued releases ahead of the next request
+    void send_releases ();
+    // drop state inherited from the parent process if running in a forked child
+    void check_fork ();
+    // send compression setting to the server
+    void negotiate ();
 
   private:
     std::string            _host;
     int                    _port;
     int                    _retries;
+    RSocketOptions         _options;
+    std::string            _capture;
+    bool                   _captured;
     CLRFactory*            _factory;
-    RTcpClient*            _tcp;
+    RTransport*            _transport;
     BufferedSocketReader*  _sin;
     BufferedSocketWriter*  _sout;
+    int                    _pid;
+    int                    _compression;
+
+    bool                   _batching;
+    int                    _pending;
+    std::vector<RObject>   _replies;
+    std::vector<CLRStats::Sample> _inflight;
+    std::string            _batch_error;
+
+    std::vector<int32_t>   _released;
+    bool                   _releases_due;
+    HandleMap              _handles;
+    std::unordered_set<int32_t> _inherited;
+
+    CLRStats               _stats;
 };
 
 
@@ -22,19 +22,26 @@
 
 
 #include <cstdlib>
+#include <cstring>
 #include "Common.hpp"
 #include "msgs/CLRMessage.hpp"
 #include "CLRObjectRef.hpp"
 #include "CLRFactory.hpp"
+#include "CLRApi.hpp"
+#include "msgs/data/CLRBitArray.hpp"
 #include "msgs/data/CLRBool.hpp"
 #include "msgs/data/CLRBoolArray.hpp"
 #include "msgs/data/CLRByte.hpp"
+#include "msgs/data/CLRByteArray.hpp"
+#include "msgs/data/CLRCompressed.hpp"
 #include "msgs/data/CLRException.hpp"
+#include "msgs/data/CLRFloat32Array.hpp"
 #include "msgs/data/CLRFloat64.hpp"
 #include "msgs/data/CLRFloat64Array.hpp"
 #include "msgs/data/CLRInt32.hpp"
 #include "msgs/data/CLRInt32Array.hpp"
 #include "msgs/data/CLRInt64.hpp"
+#include "msgs/data/CLRInt64Array.hpp"
 #include "msgs/data/CLRMatrix.hpp"
 #include "msgs/data/CLRNull.hpp"
 #include "msgs/data/CLRString.hpp"
@@ -97,21 +104,27 @@ CLRMessage* CLRFactory::messageById (char mtype)
         return new CLRMatrix (_api);
     case CLRMessage::TypeException:
         return new CLRException (_api);
+    case CLRMessage::TypeCompressed:
+        return new CLRCompressed (_api);
 
     case CLRMessage::TypeBoolArray:
         return new CLRBoolArray (_api);
     case CLRMessage::TypeByteArray:
-        throw std::runtime_error ("CLRMessage: R does not support byte arrays");
+        return new CLRByteArray (_api);
+    case CLRMessage::TypeFloat32Array:
+        return new CLRFloat32Array (_api);
     case CLRMessage::TypeInt32Array:
         return new CLRInt32Array (_api);
     case CLRMessage::TypeInt64Array:
-        throw std::runtime_error ("CLRMessage: R does not support int64 arrays");
+        return new CLRInt64Array (_api);
     case CLRMessage::TypeFloat64Array:
         return new CLRFloat64Array (_api);
     case CLRMessage::TypeStringArray:
         return new CLRStringArray (_api);
     case CLRMessage::TypeObjectArray:
       return new CLRObjectArray (_api);
+    case CLRMessage::TypeBitArray:
+        return new CLRBitArray (_api);
 	   
     case CLRMessage::TypeCallMethod:
         throw std::runtime_error ("CLRMessage: should never receive a CLRCallMethod msg");
@@ -123,132 +136,204 @@ CLRMessage* CLRFactory::messageById (char mtype)
 
 
 //
-//  create message for string(1) class
+//  direct decoders for scalar and array values (avoiding a message and copy of the value per reply)
 //
-static CLRMessage* messageForString1 (CLRApi* api, const RObject& robj)
+typedef SEXP (*ValueDecoder) (BufferedSocketReader& stream);
+
+static SEXP decodeNull (BufferedSocketReader& stream)
 {
-    std::string* v = new std::string (Rcpp::as<std::string>(robj));
-    return new CLRString (api, v);
+    return R_NilValue;
 }
 
-//
-//  create message for string(*) class
-//
-static CLRMessage* messageForStrings (CLRApi* api, const RObject& robj)
+static SEXP decodeBool (BufferedSocketReader& stream)
 {
-    CharacterVector vec (robj.get__());
-    if (vec.size() == 1) 
-        return new CLRString (api, new std::string(vec[0]));
-    else
-        return new CLRStringArray(api, new CharacterVector(vec));
+    return Rf_ScalarLogical (stream.read_byte() != (char)0);
 }
 
-//
-//  create message for bool(*) class
-//
-static CLRMessage* messageForLogicals (CLRApi* api, const RObject& robj)
+static SEXP decodeByte (BufferedSocketReader& stream)
 {
-    LogicalVector vec (robj.get__());
-    if (vec.size() == 1)
-    {
-        bool* v = new bool;
-	*v = vec[0];
-        return new CLRBool (api, v);
-    } else
-        return new CLRBoolArray(api, new LogicalVector(vec));
+    return Rf_ScalarRaw ((Rbyte)stream.read_byte());
+}
+
+static SEXP decodeInt32 (BufferedSocketReader& stream)
+{
+    return Rf_ScalarInteger (stream.read_int32());
+}
+
+static SEXP decodeInt64 (BufferedSocketReader& stream)
+{
+    // as a bit64 integer64 scalar (int64 held in double storage), as for Int64 arrays
+    int64_t value = stream.read_int64();
+    Rcpp::Shield<SEXP> vec (Rf_allocVector (REALSXP, 1));
+    memcpy (REAL(vec), &value, sizeof(value));
+    Rf_setAttrib (vec, R_ClassSymbol, Rf_mkString ("integer64"));
+    return vec;
+}
+
+static SEXP decodeFloat64 (BufferedSocketReader& stream)
+{
+    return Rf_ScalarReal (stream.read_float64());
+}
+
+static SEXP decodeString (BufferedSocketReader& stream)
+{
+    return Rf_ScalarString (stream.read_charsxp());
+}
+
+static SEXP decodeBoolArray (BufferedSocketReader& stream)
+{
+    return stream.read_bool_array();
+}
+
+static SEXP decodeBitArray (BufferedSocketReader& stream)
+{
+    return stream.read_bit_array();
+}
+
+static SEXP decodeByteArray (BufferedSocketReader& stream)
+{
+    return stream.read_byte_array();
+}
+
+static SEXP decodeInt32Array (BufferedSocketReader& stream)
+{
+    return stream.read_int32_array();
+}
+
+static SEXP decodeInt64Array (BufferedSocketReader& stream)
+{
+    Rcpp::Shield<SEXP> vec (stream.read_int64_array());
+    Rf_setAttrib (vec, R_ClassSymbol, Rf_mkString ("integer64"));
+    return vec;
+}
+
+static SEXP decodeFloat32Array (BufferedSocketReader& stream)
+{
+    return stream.read_float32_array();
+}
+
+static SEXP decodeFloat64Array (BufferedSocketReader& stream)
+{
+    return stream.read_float64_array();
+}
+
+static SEXP decodeStringArray (BufferedSocketReader& stream)
+{
+    return stream.read_string_array();
 }
 
 //
-//  create message for int(*) class
+//  dispatch table of direct decoders by message type (NULL for types requiring a message)
 //
-static CLRMessage* messageForIntegers (CLRApi* api, const RObject& robj)
+static struct ValueDecoders
 {
-    IntegerVector vec (robj.get__());
-    if (vec.size() == 1)
+    ValueDecoders ()
     {
-        int* v = new int;
-	*v = vec[0];
-        return new CLRInt32 (api, v);
-    } else
-        return new CLRInt32Array(api, new IntegerVector(vec));
-}
+        for (int i = 0 ; i < 256 ; i++)
+	    byid[i] = NULL;
+
+	set (CLRMessage::TypeNull, decodeNull);
+	set (CLRMessage::TypeBool, decodeBool);
+	set (CLRMessage::TypeByte, decodeByte);
+	set (CLRMessage::TypeInt32, decodeInt32);
+	set (CLRMessage::TypeInt64, decodeInt64);
+	set (CLRMessage::TypeFloat64, decodeFloat64);
+	set (CLRMessage::TypeString, decodeString);
+
+	set (CLRMessage::TypeBoolArray, decodeBoolArray);
+	set (CLRMessage::TypeBitArray, decodeBitArray);
+	set (CLRMessage::TypeByteArray, decodeByteArray);
+	set (CLRMessage::TypeInt32Array, decodeInt32Array);
+	set (CLRMessage::TypeInt64Array, decodeInt64Array);
+	set (CLRMessage::TypeFloat32Array, decodeFloat32Array);
+	set (CLRMessage::TypeFloat64Array, decodeFloat64Array);
+	set (CLRMessage::TypeStringArray, decodeStringArray);
+    }
+
+    void set (char mtype, ValueDecoder decoder)
+    {
+        byid[(unsigned char)mtype] = decoder;
+    }
+
+    ValueDecoder byid[256];
+} Decoders;
 
 
 //
-//  create message for matrix
+// decode scalar or array value directly to SEXP, or return NULL if the type requires a message
 //
-static CLRMessage* messageForMatrix (CLRApi* api, const RObject& robj)
+SEXP CLRFactory::valueById (char mtype, BufferedSocketReader& stream)
 {
-    NumericMatrix* mat = new NumericMatrix(robj.get__());
-    return new CLRMatrix(api, mat);
+    ValueDecoder decoder = Decoders.byid[(unsigned char)mtype];
+    if (decoder == NULL)
+        return NULL;
+    else
+        return decoder (stream);
 }
 
 
 //
-//  create message for double(*) class
+//  message type for string(*) class
 //
-static CLRMessage* messageForFloats (CLRApi* api, const RObject& robj)
+static char typeForStrings (SEXP robj)
 {
-    SEXP edim = robj.attr("dim");
-    if (!Rf_isNull(edim))
-        return messageForMatrix (api, robj);
-    
-    NumericVector vec (robj.get__());    
-    if (vec.size() == 1)
-    {
-        double* v = new double;
-	*v = vec[0];
-        return new CLRFloat64 (api, v);
-    } else
-        return new CLRVector(api, new NumericVector(vec));
+    return LENGTH(robj) == 1 ? CLRMessage::TypeString : CLRMessage::TypeStringArray;
 }
 
-
 //
-//  determine if object reference
+//  message type for bool(*) class
 //
-static bool isObjectRef (CLRApi* api, const RObject& robj)
+static char typeForLogicals (SEXP robj)
 {
-    SEXP objid = robj.attr("ObjectId");
-    return !Rf_isNull(objid);
+    return LENGTH(robj) == 1 ? CLRMessage::TypeBool : CLRMessage::TypeBitArray;
 }
 
 //
-//  create message for object
+//  message type for int(*) class
 //
-static CLRMessage* messageForObject (CLRApi* api, const RObject& robj)
+static char typeForIntegers (SEXP robj)
 {
-    return new CLRObjectRef(api, robj.get__());
+    return LENGTH(robj) == 1 ? CLRMessage::TypeInt32 : CLRMessage::TypeInt32Array;
 }
 
 //
-//  create message for object list
+//  message type for double(*) class, including bit64 integer64 (int64 values held in double storage),
+//  float32 and matrix
 //
-static CLRMessage* messageForObjectList (CLRApi* api, const RObject& robj)
+static char typeForFloats (SEXP robj)
 {
-    return new CLRObjectArray(api, new List(robj.get__()));
+    if (Rf_inherits (robj, "integer64"))
+        return LENGTH(robj) == 1 ? CLRMessage::TypeInt64 : CLRMessage::TypeInt64Array;
+    if (Rf_inherits (robj, "float32"))
+        return CLRMessage::TypeFloat32Array;
+
+    if (!Rf_isNull(Rf_getAttrib (robj, R_DimSymbol)))
+        return CLRMessage::TypeMatrix;
+    
+    return LENGTH(robj) == 1 ? CLRMessage::TypeFloat64 : CLRMessage::TypeVector;
 }
 
+
 //
-// create message based on R object type
+// determine value message type for R object
 //
-CLRMessage* CLRFactory::messageByValue (const RObject& robj)
+char CLRFactory::typeByValue (SEXP robj)
 {
-    int stype = robj.sexp_type();
+    int stype = TYPEOF(robj);
     switch (stype)
     {
     case NILSXP:
-        return new CLRNull(_api);  
+        return CLRMessage::TypeNull;
     case CHARSXP:
-      return messageForString1 (_api, robj);
+        return CLRMessage::TypeString;
     case LGLSXP:
-        return messageForLogicals (_api, robj);
+        return typeForLogicals (robj);
     case INTSXP:
-        return messageForIntegers (_api, robj);
+        return typeForIntegers (robj);
     case REALSXP:
-        return messageForFloats (_api, robj);
+        return typeForFloats (robj);
     case STRSXP:
-        return messageForStrings (_api, robj);
+        return typeForStrings (robj);
     case SYMSXP:
         throw std::runtime_error ("CLRMessage: cannot handle R symbol type");
     case LISTSXP:
@@ -272,20 +357,20 @@ CLRMessage* CLRFactory::messageByValue (const RObject& robj)
     case ANYSXP:
         throw std::runtime_error ("CLRMessage: cannot handle R ANY type");
     case VECSXP:
-        if (isObjectRef (_api, robj))
-            return messageForObject(_api, robj);
-	else
-	    return messageForObjectList(_api, robj);
+        return CLRMessage::TypeObjectArray;
     case EXPRSXP:
         throw std::runtime_error ("CLRMessage: cannot handle R expression type");
     case BCODESXP:
         throw std::runtime_error ("CLRMessage: cannot handle R bytecode type");
     case EXTPTRSXP:
-        throw std::runtime_error ("CLRMessage: cannot handle R external-pointer type");
+        if (CLRObjectRef::isHandle (robj))
+            return CLRMessage::TypeObject;
+	else
+	    throw std::runtime_error ("CLRMessage: cannot handle R external-pointer type");
     case WEAKREFSXP:
         throw std::runtime_error ("CLRMessage: cannot handle R weak-reference type");
     case RAWSXP:
-        throw std::runtime_error ("CLRMessage: cannot handle R raw-bytes type");
+        return CLRMessage::TypeByteArray;
     case S4SXP:
         throw std::runtime_error ("CLRMessage: cannot handle R S4 type");
     case FUNSXP:
@@ -294,3 +379,112 @@ CLRMessage* CLRFactory::messageByValue (const RObject& robj)
         throw std::runtime_error ("CLRMessage: unknown R type");
     }
 }
+
+
+//
+// write R object as a value message of the given type, straight from the R object's storage
+//
+void CLRFactory::writeValue (BufferedSocketWriter& stream, char mtype, SEXP robj)
+{
+    // magic sequence opener & type
+    stream.write_int16 (CLRMessage::Magic);
+    stream.write_byte (mtype);
+
+    switch (mtype)
+    {
+    case CLRMessage::TypeNull:
+        break;
+    case CLRMessage::TypeBool:
+        stream.write_byte (LOGICAL(robj)[0] ? (char)1 : (char)0);
+	break;
+    case CLRMessage::TypeInt32:
+        stream.write_int32 (INTEGER(robj)[0]);
+	break;
+    case CLRMessage::TypeInt64:
+        stream.write_bytes (REAL(robj), sizeof(int64_t));
+	break;
+    case CLRMessage::TypeFloat64:
+        stream.write_float64 (REAL(robj)[0]);
+	break;
+    case CLRMessage::TypeString:
+        stream.write_string (Rf_translateCharUTF8 (TYPEOF(robj) == CHARSXP ? robj : STRING_ELT (robj, 0)));
+	break;
+    case CLRMessage::TypeObject:
+        CLRObjectRef::write (stream, robj);
+	break;
+
+    case CLRMessage::TypeVector:
+        CLRVector::write (stream, robj);
+	break;
+    case CLRMessage::TypeMatrix:
+        CLRMatrix::write (stream, robj);
+	break;
+
+    case CLRMessage::TypeBitArray:
+        stream.write_bit_array (robj);
+	break;
+    case CLRMessage::TypeByteArray:
+        stream.write_byte_array (robj);
+	break;
+    case CLRMessage::TypeFloat32Array:
+        stream.write_float32_array (robj);
+	break;
+    case CLRMessage::TypeInt32Array:
+        stream.write_int32_array (robj);
+	break;
+    case CLRMessage::TypeInt64Array:
+        stream.write_int64_array (robj);
+	break;
+    case CLRMessage::TypeStringArray:
+        stream.write_string_array (robj);
+	break;
+    case CLRMessage::TypeObjectArray:
+        CLRObjectArray::write (stream, this, robj);
+	break;
+
+    default:
+        throw CLRUnknownMessageException (mtype);
+    }
+}
+
+
+//
+// write R object as a value message
+//
+//  Once compression is agreed with the server, arrays and matrices of at least the threshold size
+//  are serialized into memory and sent in a compressed envelope.
+//
+void CLRFactory::serializeValue (BufferedSocketWriter& stream, SEXP robj)
+{
+    char mtype = typeByValue (robj);
+    int threshold = _api->compression();
+    int width = CLRCompressed::width (mtype);
+
+    // smaller than threshold (judging by the element data alone): write directly
+    if (threshold <= 0 || width == 0 || (double)Rf_xlength(robj) * width < threshold)
+    {
+        writeValue (stream, mtype, robj);
+	return;
+    }
+
+    size_t len = 0;
+    try
+    {
+        stream.begin_block();
+	writeValue (stream, mtype, robj);
+	len = stream.end_block();
+    }
+    catch (...)
+    {
+        stream.end_block();
+	throw;
+    }
+
+    if (len < (size_t)threshold)
+        stream.write_bytes (stream.block(), len);
+    else
+    {
+        CLRCompressed envelope (_api, width, stream.block(), len);
+	envelope.serialize (stream);
+    }
+}
@@ -44,8 +44,17 @@ class CLRFactory
     // create message based on incoming message ID 
     CLRMessage* messageById (char mtype);
 
-    // create message based on R object type
-    CLRMessage* messageByValue (const RObject& robj);
+    // decode scalar or array value of given type directly to (unprotected) SEXP, or NULL if a message is required
+    SEXP valueById (char mtype, BufferedSocketReader& stream);
+
+    // determine value message type for R object
+    char typeByValue (SEXP robj);
+
+    // write R object as a value message of the given type, directly from the R object
+    void writeValue (BufferedSocketWriter& stream, char mtype, SEXP robj);
+
+    // write R object as a value message, compressing it if large enough
+    void serializeValue (BufferedSocketWriter& stream, SEXP robj);
 
   private:
     CLRApi* _api;
@@ -25,6 +25,7 @@
 #include <cstdlib>
 #include "CLRObjectRef.hpp"
 #include "CLRApi.hpp"
+#include "OS.hpp"
 
 #undef TRUE
 #undef FALSE
@@ -36,27 +37,60 @@ using namespace std;
 //
 struct CLRObjectGC
 {
-    CLRObjectGC(int objectId, CLRApi* api) : ObjectId(objectId), API(api) {}
+    CLRObjectGC(int objectId, CLRApi* api) : ObjectId(objectId), API(api), Pid(process_id()), Reused(false) {}
 
     int      ObjectId;
     CLRApi*  API;
+    int      Pid;
+    bool     Reused;
 };
 
 
-// release object handle
-static void ObjectFinalizer (SEXP sptr)
+static void ObjectFinalizer (SEXP handle);
+
+// finalize handle once unreachable, recording it as the live handle for its object
+static void track (CLRObjectGC* xgc, SEXP handle)
 {
-     if (TYPEOF(sptr) != EXTPTRSXP)
-         throw std::runtime_error ("bad finalizer pointer sent in rDotNet gc()");
+    SEXP ref = R_MakeWeakRefC (handle, R_NilValue, ObjectFinalizer, TRUE);
+    xgc->API->track (xgc->ObjectId, ref);
+}
 
+// release object handle
+static void ObjectFinalizer (SEXP handle)
+{
      // retrieve .NET GC handle (not really a pointer)
-     CLRObjectGC* xgc = (CLRObjectGC*)((void*)R_ExternalPtrAddr (sptr));
-
-     // inform API that object done
-     xgc->API->release (xgc->ObjectId);
+     CLRObjectGC* xgc = (CLRObjectGC*)((void*)R_ExternalPtrAddr (handle));
+     if (xgc == NULL)
+         return;
+
+     // handle was returned again since the last check, possibly after the GC found it unreachable:
+     // keep it, releasing the object only if it is still unreachable at a later collection
+     if (xgc->Reused)
+     {
+         xgc->Reused = false;
+	 track (xgc, handle);
+	 return;
+     }
+
+     // inform API that object done (objects inherited across a fork belong to the parent)
+     if (xgc->Pid == process_id())
+         xgc->API->release (xgc->ObjectId);
+     R_ClearExternalPtr (handle);
      delete xgc;
 }
 
+// class attribute shared by all handles
+static SEXP handleClass ()
+{
+    static SEXP klass = NULL;
+    if (klass == NULL)
+    {
+        klass = Rf_mkString ("rDotNet");
+	R_PreserveObject (klass);
+    }
+    return klass;
+}
+
 
 // R value associated with this message
 RValue CLRObjectRef::rvalue()
@@ -68,38 +102,75 @@ RValue CLRObjectRef::rvalue()
 void CLRObjectRef::serialize (BufferedSocketWriter& stream)
 {
     CLRMessage::serialize (stream);
+    write (stream, _object);
+}
 
-    List list(_object);
-    SEXP eId = list.attr("ObjectId");
-    if (Rf_isNull(eId))
-        throw std::runtime_error ("CLRMessage: object reference missing object ID");
-	
-    stream.write_int32 (Rcpp::as<int>(eId));
+// write object reference body from R object handle
+void CLRObjectRef::write (BufferedSocketWriter& stream, SEXP obj)
+{
+    stream.write_int32 (objectIdOf (obj));
     stream.write_byte(0);
 }
 
 // deserialize object from stream
 void CLRObjectRef::deserialize (BufferedSocketReader& stream)
 {
-    List vobj;
-    vobj.attr("class") = "rDotNet";
-
     // object ID
     int objectId = stream.read_int32();
-    vobj.attr("ObjectId") = objectId;
 
     // class name
+    SEXP classname = R_NilValue;
     if (stream.read_byte() != 0)
-        vobj.attr("Classname") = stream.read_string();
-
-    // setup garbage collection
+        classname = stream.read_charsxp();
+
+    // object already has a live handle
+    SEXP handle = _api->handle (objectId);
+    CLRObjectGC* xgc = handle != NULL ? (CLRObjectGC*)R_ExternalPtrAddr (handle) : NULL;
+    if (xgc != NULL)
+    {
+        xgc->Reused = true;
+	_object = RValue (handle);
+	return;
+    }
+
+    // new handle, released through its finalizer (the id is kept in the tag, which survives serialization)
+    PROTECT (classname);
+    SEXP id = PROTECT (Rf_ScalarInteger (objectId));
     CLRObjectGC* gc = new CLRObjectGC(objectId, _api);
-    SEXP xgc = PROTECT(R_MakeExternalPtr((void*)gc, R_NilValue, R_NilValue));
-    vobj.attr("gc") = xgc;
+    handle = PROTECT (R_MakeExternalPtr ((void*)gc, id, classname));
+    Rf_setAttrib (handle, R_ClassSymbol, handleClass());
+    track (gc, handle);
+    UNPROTECT(3);
+
+    _object = RValue (handle);
+}
+
+// determine whether R value is an object handle
+bool CLRObjectRef::isHandle (SEXP obj)
+{
+    return TYPEOF(obj) == EXTPTRSXP && Rf_inherits (obj, "rDotNet");
+}
 
-    R_RegisterCFinalizerEx(xgc, ObjectFinalizer, TRUE);
+// object id of R object handle
+int CLRObjectRef::objectIdOf (SEXP obj)
+{
+    if (!isHandle (obj))
+        throw std::runtime_error ("CLRObject: cannot find object handle");
+
+    SEXP id = R_ExternalPtrTag (obj);
+    if (TYPEOF(id) != INTSXP || LENGTH(id) != 1)
+        throw std::runtime_error ("CLRObject: object handle missing object ID");
+
+    return INTEGER(id)[0];
+}
+
+// class name of R object handle (NULL if not known)
+SEXP CLRObjectRef::classnameOf (SEXP obj)
+{
+    if (!isHandle (obj))
+        throw std::runtime_error ("CLRObject: cannot find object handle");
 
-    _object = RValue(Rcpp::wrap(vobj));
-    UNPROTECT(1);
+    SEXP classname = R_ExternalPtrProtected (obj);
+    return Rf_isNull (classname) ? R_NilValue : Rf_ScalarString (classname);
 }
 
@@ -32,7 +32,11 @@ using namespace std;
 
 
 //
-// Object Reference (uses a list object to hold information about object)
+// Object Reference
+//
+//  R holds a .NET object through a handle: an external pointer of class rDotNet, tagged with the object id
+//  and carrying the class name, with a finalizer releasing the object.  There is at most one live handle
+//  per object.
 //
 class CLRObjectRef : public CLRMessage
 {
@@ -46,6 +50,16 @@ class CLRObjectRef : public CLRMessage
 
     // serialize object to stream
     void serialize (BufferedSocketWriter& stream);
+
+    // write object reference body (the object id) from an R object handle
+    static void write (BufferedSocketWriter& stream, SEXP obj);
+
+    // determine whether R value is an object handle
+    static bool isHandle (SEXP obj);
+    // object id of R object handle
+    static int objectIdOf (SEXP obj);
+    // class name of R object handle (NULL if not known)
+    static SEXP classnameOf (SEXP obj);
   
     // deserialize object from stream
     void deserialize (BufferedSocketReader& stream);
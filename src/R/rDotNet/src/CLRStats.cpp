@@ -0,0 +1,201 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#include "Common.hpp"
+#include "CLRStats.hpp"
+#include "msgs/CLRMessage.hpp"
+
+using namespace std;
+using namespace Rcpp;
+
+
+// record completed request
+void CLRStats::record (const Sample& sample)
+{
+    Entry& entry = _entries[make_pair (sample.type, sample.name)];
+
+    double total = 0;
+    for (int i = 0 ; i < Phases ; i++)
+    {
+        entry.phases[i] += sample.phases[i];
+	total += sample.phases[i];
+    }
+
+    // bucket i holds latencies in [2^(i-1), 2^i) us
+    int bucket = 0;
+    while (bucket < (Buckets-1) && total >= (double)(1 << bucket))
+        bucket++;
+
+    entry.histogram[bucket]++;
+    entry.calls++;
+    entry.sent += sample.sent;
+    entry.received += sample.received;
+}
+
+
+// clear all counters
+void CLRStats::reset ()
+{
+    _entries.clear();
+}
+
+
+// counters as a data.frame, one row per message type and method
+List CLRStats::frame () const
+{
+    int n = (int)_entries.size();
+
+    CharacterVector type (n);
+    CharacterVector name (n);
+    NumericVector calls (n);
+    NumericVector sent (n);
+    NumericVector received (n);
+    NumericVector serialize (n);
+    NumericVector wait (n);
+    NumericVector deserialize (n);
+    NumericVector wrap (n);
+    List histogram (n);
+
+    // histogram bins are labelled by their (exclusive) upper bound in us
+    CharacterVector bins (Buckets);
+    for (int i = 0 ; i < Buckets ; i++)
+        bins[i] = std::to_string ((long long)1 << i);
+
+    int row = 0;
+    for (EntryMap::const_iterator it = _entries.begin() ; it != _entries.end() ; ++it, ++row)
+    {
+        const Entry& entry = it->second;
+	type[row] = type_name (it->first.first);
+	name[row] = it->first.second;
+	calls[row] = entry.calls;
+	sent[row] = entry.sent;
+	received[row] = entry.received;
+	serialize[row] = entry.phases[Serialize];
+	wait[row] = entry.phases[Wait];
+	deserialize[row] = entry.phases[Deserialize];
+	wrap[row] = entry.phases[Wrap];
+
+	IntegerVector counts (entry.histogram, entry.histogram + Buckets);
+	counts.attr("names") = bins;
+	histogram[row] = counts;
+    }
+
+    // built by hand rather than with DataFrame::create so that histogram stays a list column
+    List frame = List::create (
+        Named("type") = type,
+	Named("name") = name,
+	Named("calls") = calls,
+	Named("bytes_sent") = sent,
+	Named("bytes_received") = received,
+	Named("serialize_us") = serialize,
+	Named("wait_us") = wait,
+	Named("deserialize_us") = deserialize,
+	Named("wrap_us") = wrap,
+	Named("histogram") = histogram);
+
+    IntegerVector rows = seq_len (n);
+    frame.attr("row.names") = rows;
+    frame.attr("class") = "data.frame";
+    return frame;
+}
+
+
+// name of message type
+const char* CLRStats::type_name (char type)
+{
+    switch (type)
+    {
+        case CLRMessage::TypeNull:
+	    return "Null";
+        case CLRMessage::TypeBool:
+	    return "Bool";
+        case CLRMessage::TypeByte:
+	    return "Byte";
+        case CLRMessage::TypeInt32:
+	    return "Int32";
+        case CLRMessage::TypeInt64:
+	    return "Int64";
+        case CLRMessage::TypeFloat64:
+	    return "Float64";
+        case CLRMessage::TypeString:
+	    return "String";
+        case CLRMessage::TypeObject:
+	    return "Object";
+        case CLRMessage::TypeVector:
+	    return "Vector";
+        case CLRMessage::TypeMatrix:
+	    return "Matrix";
+        case CLRMessage::TypeException:
+	    return "Exception";
+        case CLRMessage::TypeCompressed:
+	    return "Compressed";
+        case CLRMessage::TypeBoolArray:
+	    return "BoolArray";
+        case CLRMessage::TypeByteArray:
+	    return "ByteArray";
+        case CLRMessage::TypeFloat32Array:
+	    return "Float32Array";
+        case CLRMessage::TypeInt32Array:
+	    return "Int32Array";
+        case CLRMessage::TypeInt64Array:
+	    return "Int64Array";
+        case CLRMessage::TypeFloat64Array:
+	    return "Float64Array";
+        case CLRMessage::TypeStringArray:
+	    return "StringArray";
+        case CLRMessage::TypeObjectArray:
+	    return "ObjectArray";
+        case CLRMessage::TypeBitArray:
+	    return "BitArray";
+        case CLRMessage::TypeCreate:
+	    return "Create";
+        case CLRMessage::TypeCallStaticMethod:
+	    return "CallStatic";
+        case CLRMessage::TypeCallMethod:
+	    return "CallMethod";
+        case CLRMessage::TypeGetProperty:
+	    return "GetProperty";
+        case CLRMessage::TypeGetIndexed:
+	    return "GetIndexed";
+        case CLRMessage::TypeSetProperty:
+	    return "SetProperty";
+        case CLRMessage::TypeRelease:
+	    return "Release";
+        case CLRMessage::TypeReleaseBatch:
+	    return "ReleaseBatch";
+        case CLRMessage::TypePrepare:
+	    return "Prepare";
+        case CLRMessage::TypeInvoke:
+	    return "Invoke";
+        case CLRMessage::TypeCompression:
+	    return "Compression";
+        case CLRMessage::TypeChain:
+	    return "Chain";
+        case CLRMessage::TypeGetProperties:
+	    return "GetProperties";
+        case CLRMessage::TypeProject:
+	    return "Project";
+        default:
+	    return "Unknown";
+    }
+}
@@ -0,0 +1,127 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#ifndef CLR_STATS
+#define CLR_STATS
+
+#include <Rcpp.h>
+#include <chrono>
+#include <map>
+#include <string>
+#include <utility>
+#include <stdint.h>
+
+using namespace Rcpp;
+
+
+//
+// Per message type and method counters for requests to the CLR
+//
+//  Latency is split into phases:
+//	- serialize:	writing the request into the stream buffer
+//	- wait:		flushing the request until the reply header arrives (network + CLR compute)
+//	- deserialize:	reading the reply body
+//	- wrap:		converting the reply to an R value
+//
+class CLRStats
+{
+  public:
+
+    typedef std::chrono::steady_clock Clock;
+
+    enum Phase { Serialize = 0, Wait = 1, Deserialize = 2, Wrap = 3, Phases = 4 };
+
+    // # of log2 latency buckets, from < 1us to >= 2^30 us
+    static const int Buckets = 32;
+
+    //
+    // timings and sizes for a single request
+    //
+    struct Sample
+    {
+        Sample (char type, const std::string& name)
+	  : type(type), name(name), sent(0), received(0), mark(Clock::now())
+	{
+	    for (int i = 0 ; i < Phases ; i++)
+	        phases[i] = 0;
+	}
+
+	// start timing the next phase from now
+	void restart ()
+	{
+	    mark = Clock::now();
+	}
+
+	// accumulate time since the last mark into given phase
+	void lap (Phase phase)
+	{
+	    Clock::time_point now = Clock::now();
+	    phases[phase] += std::chrono::duration<double, std::micro>(now - mark).count();
+	    mark = now;
+	}
+
+	char               type;
+	std::string        name;
+	uint64_t           sent;
+	uint64_t           received;
+	double             phases[Phases];
+	Clock::time_point  mark;
+    };
+
+    // record completed request
+    void record (const Sample& sample);
+
+    // clear all counters
+    void reset ();
+
+    // counters as a data.frame, one row per message type and method
+    List frame () const;
+
+    // name of message type
+    static const char* type_name (char type);
+
+  private:
+
+    struct Entry
+    {
+        Entry () : calls(0), sent(0), received(0)
+	{
+	    for (int i = 0 ; i < Phases ; i++)
+	        phases[i] = 0;
+	    for (int i = 0 ; i < Buckets ; i++)
+	        histogram[i] = 0;
+	}
+
+	double    calls;
+	double    sent;
+	double    received;
+	double    phases[Phases];
+	int       histogram[Buckets];
+    };
+
+    typedef std::map<std::pair<char,std::string>, Entry> EntryMap;
+
+    EntryMap   _entries;
+};
+
+#endif
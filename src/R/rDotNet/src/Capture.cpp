@@ -0,0 +1,198 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#include "Capture.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+
+//
+//  Capture
+//
+
+
+RCaptureTransport::RCaptureTransport (RTransport* transport, const std::string& path, bool append)
+    : _transport(transport), _file(NULL), _start(std::chrono::steady_clock::now())
+{
+    _file = fopen (path.c_str(), append ? "ab" : "wb");
+    if (_file == NULL)
+    {
+        delete transport;
+        throw runtime_error ("could not create capture file: " + path);
+    }
+
+    if (!append)
+    {
+        int32_t header[2] = { RCapture::Magic, RCapture::Version };
+	fwrite (header, sizeof(header), 1, _file);
+	fflush (_file);
+    }
+}
+
+
+RCaptureTransport::~RCaptureTransport ()
+{
+    if (_file != NULL)
+        fclose (_file);
+
+    delete _transport;
+}
+
+
+// read data into buffer 
+int RCaptureTransport::read (byte* buffer, int bufferlen, int retries)
+{
+    int len = _transport->read (buffer, bufferlen, retries);
+    if (len > 0)
+        record (RCapture::Received, buffer, len);
+
+    return len;
+}
+
+
+// write data 
+int RCaptureTransport::write (const byte* buffer, int len, int retries)
+{
+    int done = _transport->write (buffer, len, retries);
+    if (done > 0)
+        record (RCapture::Sent, buffer, done);
+
+    return done;
+}
+
+
+// close transport
+void RCaptureTransport::close ()
+{
+    if (_file != NULL)
+    {
+        fclose (_file);
+	_file = NULL;
+    }
+
+    _transport->close();
+}
+
+
+// let go of inherited transport and capture file (records are flushed as written, so nothing is duplicated)
+void RCaptureTransport::abandon ()
+{
+    if (_file != NULL)
+    {
+        fclose (_file);
+	_file = NULL;
+    }
+
+    _transport->abandon();
+}
+
+
+// append record to capture file (flushed so that the capture survives the R session ending)
+void RCaptureTransport::record (uint8_t direction, const byte* buffer, int len)
+{
+    if (_file == NULL)
+        return;
+
+    int64_t when = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - _start).count();
+    int32_t length = len;
+
+    fwrite (&direction, sizeof(direction), 1, _file);
+    fwrite (&when, sizeof(when), 1, _file);
+    fwrite (&length, sizeof(length), 1, _file);
+    fwrite (buffer, 1, len, _file);
+    fflush (_file);
+}
+
+
+//
+//  Replay
+//
+
+
+RReplayTransport::RReplayTransport (const std::string& path, int repeat)
+    : _pos(0), _repeat(repeat), _played(0)
+{
+    FILE* file = fopen (path.c_str(), "rb");
+    if (file == NULL)
+        throw runtime_error ("could not open capture file: " + path);
+
+    int32_t header[2];
+    if (fread (header, sizeof(header), 1, file) != 1 || header[0] != RCapture::Magic)
+    {
+        fclose (file);
+        throw runtime_error ("not a capture file: " + path);
+    }
+    if (header[1] != RCapture::Version)
+    {
+        fclose (file);
+        throw runtime_error ("unsupported capture file version: " + path);
+    }
+
+    // concatenate the received data, skipping requests
+    uint8_t direction;
+    int64_t when;
+    int32_t length;
+    while (fread (&direction, sizeof(direction), 1, file) == 1)
+    {
+        if (fread (&when, sizeof(when), 1, file) != 1 || fread (&length, sizeof(length), 1, file) != 1)
+	    break;
+
+	if (direction != RCapture::Received)
+	{
+	    fseek (file, length, SEEK_CUR);
+	    continue;
+	}
+
+	size_t pos = _replies.size();
+	_replies.resize (pos + length);
+	if (fread (&_replies[pos], 1, length, file) != (size_t)length)
+	{
+	    // truncated record (capture was cut short)
+	    _replies.resize (pos);
+	    break;
+	}
+    }
+
+    fclose (file);
+}
+
+
+// read data into buffer 
+int RReplayTransport::read (byte* buffer, int bufferlen, int retries)
+{
+    if (_pos == _replies.size())
+    {
+        if (++_played >= _repeat || _replies.empty())
+	    return 0;
+	_pos = 0;
+    }
+
+    size_t len = std::min ((size_t)bufferlen, _replies.size() - _pos);
+    memcpy (buffer, &_replies[_pos], len);
+    _pos += len;
+    return (int)len;
+}
@@ -0,0 +1,133 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#ifndef RCAPTURE
+#define RCAPTURE
+
+#include <cstdlib>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+#include "Transport.hpp"
+
+
+//
+// Capture file layout: an 8 byte header ("RDNC" and an int32 version), followed by a record per
+// read or write on the transport:
+//
+//	uint8	direction (Sent or Received)
+//	int64	nanoseconds since the capture started
+//	int32	length
+//	byte[]	data
+//
+struct RCapture
+{
+    static const int32_t Magic       = 0x434e4452;    // "RDNC"
+    static const int32_t Version     = 1;
+
+    static const uint8_t Sent        = 1;
+    static const uint8_t Received    = 2;
+};
+
+
+//
+// Transport decorator recording all traffic on the underlying transport to a capture file
+//
+class RCaptureTransport : public RTransport
+{
+  public:
+
+    // takes ownership of transport; appends to (rather than replacing) an existing capture if requested
+    RCaptureTransport (RTransport* transport, const std::string& path, bool append = false);
+    ~RCaptureTransport ();
+
+    // determine if connected
+    bool is_connected ()
+        { return _transport->is_connected(); }
+
+    // read data into buffer 
+    int read (byte* buffer, int bufferlen, int retries = 0);
+
+    // write data 
+    int write (const byte* buffer, int len, int retries = 0);
+
+    // close transport
+    void close ();
+
+    // let go of inherited transport and capture file
+    void abandon ();
+
+  private:
+
+    void record (uint8_t direction, const byte* buffer, int len);
+
+  private:
+    RTransport*                           _transport;
+    FILE*                                 _file;
+    std::chrono::steady_clock::time_point _start;
+};
+
+
+//
+// Transport replaying the replies from a capture file, with no server attached (requests are discarded)
+//
+class RReplayTransport : public RTransport
+{
+  public:
+
+    // load replies from capture file, to be played the given # of times
+    RReplayTransport (const std::string& path, int repeat = 1);
+
+    // determine if connected
+    bool is_connected ()
+        { return true; }
+
+    // read data into buffer 
+    int read (byte* buffer, int bufferlen, int retries = 0);
+
+    // write data 
+    int write (const byte* buffer, int len, int retries = 0)
+        { return len; }
+
+    // close transport
+    void close ()
+        { }
+
+    // nothing inherited to let go of
+    void abandon ()
+        { }
+
+    // total # of reply bytes to be played
+    size_t size () const
+        { return _replies.size() * _repeat; }
+
+  private:
+    std::vector<byte>   _replies;
+    size_t              _pos;
+    int                 _repeat;
+    int                 _played;
+};
+
+#endif
@@ -0,0 +1,182 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#include "Compression.hpp"
+
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <stdexcept>
+#include <thread>
+#include <zlib.h>
+
+using namespace std;
+
+
+//
+//  Chunk codecs
+//
+
+// deflate a chunk (raw deflate stream, no zlib header)
+static bool deflate_chunk (const byte* src, size_t len, std::vector<byte>& dst)
+{
+    z_stream zs;
+    memset (&zs, 0, sizeof(zs));
+    if (deflateInit2 (&zs, Z_BEST_SPEED, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    dst.resize (deflateBound (&zs, (uLong)len));
+    zs.next_in = const_cast<Bytef*>(src);
+    zs.avail_in = (uInt)len;
+    zs.next_out = dst.data();
+    zs.avail_out = (uInt)dst.size();
+
+    int rc = deflate (&zs, Z_FINISH);
+    dst.resize (zs.total_out);
+    deflateEnd (&zs);
+    return rc == Z_STREAM_END;
+}
+
+// inflate a chunk into exactly len bytes
+static bool inflate_chunk (const std::vector<byte>& src, byte* dst, size_t len)
+{
+    z_stream zs;
+    memset (&zs, 0, sizeof(zs));
+    if (inflateInit2 (&zs, -15) != Z_OK)
+        return false;
+
+    zs.next_in = const_cast<Bytef*>(src.data());
+    zs.avail_in = (uInt)src.size();
+    zs.next_out = dst;
+    zs.avail_out = (uInt)len;
+
+    int rc = inflate (&zs, Z_FINISH);
+    bool complete = rc == Z_STREAM_END && zs.total_out == len;
+    inflateEnd (&zs);
+    return complete;
+}
+
+// apply fn to chunks 0 .. n-1, across threads if more than one
+static bool for_chunks (size_t n, const std::function<bool(size_t)>& fn)
+{
+    size_t nthreads = min (n, (size_t)min ((unsigned)RCompression::MaxThreads, max (thread::hardware_concurrency(), 1u)));
+    if (nthreads <= 1)
+    {
+        for (size_t i = 0 ; i < n ; i++)
+	    if (!fn(i)) return false;
+	return true;
+    }
+
+    atomic<size_t> next (0);
+    atomic<bool> ok (true);
+    vector<thread> threads;
+    for (size_t t = 0 ; t < nthreads ; t++)
+    {
+        threads.emplace_back ([&]() {
+	    for (size_t i = next++ ; i < n ; i = next++)
+	        if (!fn(i)) ok = false;
+	});
+    }
+
+    for (auto& t : threads)
+        t.join();
+    return ok;
+}
+
+
+//
+//  Compression
+//
+
+
+void RCompression::encode (const byte* data, size_t len, int width, std::vector< std::vector<byte> >& chunks)
+{
+    std::vector<byte> shuffled;
+    if (width > 1)
+    {
+        shuffled.resize (len);
+	shuffle (data, len, width, shuffled.data());
+	data = shuffled.data();
+    }
+
+    size_t n = (len + ChunkSize - 1) / ChunkSize;
+    chunks.resize (n);
+    bool ok = for_chunks (n, [&](size_t i) {
+        size_t offset = i * ChunkSize;
+	return deflate_chunk (data + offset, min ((size_t)ChunkSize, len - offset), chunks[i]);
+    });
+
+    if (!ok)
+        throw runtime_error ("RCompression: failed to compress value");
+}
+
+
+void RCompression::decode (const std::vector< std::vector<byte> >& chunks, size_t len, size_t chunksize, int width, std::vector<byte>& data)
+{
+    if (chunksize == 0 || chunks.size() != (len + chunksize - 1) / chunksize)
+        throw runtime_error ("RCompression: compressed value has wrong # of chunks");
+
+    std::vector<byte> shuffled (width > 1 ? len : 0);
+    data.resize (len);
+    byte* out = width > 1 ? shuffled.data() : data.data();
+
+    bool ok = for_chunks (chunks.size(), [&](size_t i) {
+        size_t offset = i * chunksize;
+	return inflate_chunk (chunks[i], out + offset, min (chunksize, len - offset));
+    });
+
+    if (!ok)
+        throw runtime_error ("RCompression: failed to decompress value");
+    if (width > 1)
+        unshuffle (shuffled.data(), len, width, data.data());
+}
+
+
+void RCompression::shuffle (const byte* src, size_t len, int width, byte* dst)
+{
+    size_t n = len / width;
+    for (int j = 0 ; j < width ; j++)
+    {
+        byte* out = dst + j * n;
+	for (size_t i = 0 ; i < n ; i++)
+	    out[i] = src[i * width + j];
+    }
+
+    // trailing partial element is left as is
+    memcpy (dst + n * width, src + n * width, len - n * width);
+}
+
+
+void RCompression::unshuffle (const byte* src, size_t len, int width, byte* dst)
+{
+    size_t n = len / width;
+    for (int j = 0 ; j < width ; j++)
+    {
+        const byte* in = src + j * n;
+	for (size_t i = 0 ; i < n ; i++)
+	    dst[i * width + j] = in[i];
+    }
+
+    memcpy (dst + n * width, src + n * width, len - n * width);
+}
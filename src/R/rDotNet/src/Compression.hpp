@@ -0,0 +1,69 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#ifndef RCOMPRESSION
+#define RCOMPRESSION
+
+#include <cstdlib>
+#include <vector>
+#include <stdint.h>
+#include "Transport.hpp"
+
+
+//
+// Compression of large values (raw deflate), as carried in a compressed value envelope:
+//
+//	uint8	codec (Deflate)
+//	uint8	element width used to shuffle the data (1 for none)
+//	int32	uncompressed length
+//	int32	chunk size
+//	for each chunk:
+//	    int32	compressed length
+//	    byte[]	compressed data
+//
+// The data is byte-shuffled before compression, grouping the 1st byte of every element, then
+// the 2nd, and so on, which exposes the redundancy in the high order bytes of doubles and ints.
+// Chunks are compressed independently, across threads for large values.
+//
+class RCompression
+{
+  public:
+
+    static const uint8_t Deflate     = 1;
+    static const int32_t ChunkSize   = 1 << 20;
+    static const int     MaxThreads  = 8;
+
+    // shuffle by element width and compress data into chunks
+    static void encode (const byte* data, size_t len, int width, std::vector< std::vector<byte> >& chunks);
+
+    // decompress chunks (of the given uncompressed size) into data of the given length, unshuffling by element width
+    static void decode (const std::vector< std::vector<byte> >& chunks, size_t len, size_t chunksize, int width, std::vector<byte>& data);
+
+  private:
+
+    // group the ith byte of each element together (and the reverse)
+    static void shuffle (const byte* src, size_t len, int width, byte* dst);
+    static void unshuffle (const byte* src, size_t len, int width, byte* dst);
+};
+
+#endif
@@ -23,18 +23,31 @@
 
 #include <Rcpp.h>
 #include <cstdlib>
+#include <memory>
 #include "Common.hpp"
 #include "CLRApi.hpp"
+#include "Capture.hpp"
 
 using namespace Rcpp;
 
 static CLRApi* api = NULL;
+// decodes captured replies offline (kept, as replayed objects may be finalized later)
+static CLRApi* replayer = NULL;
 
 
 // [[Rcpp::export]]
-void internal_cinit(const std::string& host, int port)
+void internal_cinit(const std::string& host, int port, bool nodelay = true, int sndbuf = 0, int rcvbuf = 0, bool quickack = true, bool keepalive = true, const std::string& capture = "")
 {
-    api = new CLRApi (host.c_str(), port);
+    RSocketOptions options;
+    options.nodelay = nodelay;
+    options.sndbuf = sndbuf;
+    options.rcvbuf = rcvbuf;
+    options.quickack = quickack;
+    options.keepalive = keepalive;
+
+    api = new CLRApi (host.c_str(), port, 4, options);
+    if (!capture.empty())
+        api->capture (capture);
 }
 
 
@@ -43,8 +56,8 @@ bool internal_ctest_connection(const std::string& host, int port)
 {
     try
     {
-        RTcpClient tcp (host, port);
-	return tcp.is_connected();
+        std::unique_ptr<RTransport> transport (RTransport::open (host, port));
+	return transport->is_connected();
     }
     catch (...)
     {
@@ -90,6 +103,24 @@ SEXP internal_cget (SEXP obj, const std::string& property)
     return api->get (obj, property);
 }
 
+// [[Rcpp::export]]
+SEXP internal_cget_many (SEXP obj, const CharacterVector& properties)
+{
+    if (api == NULL)
+        internal_cinit ("localhost", 56789);
+	       
+    return api->get_many (obj, properties);
+}
+
+// [[Rcpp::export]]
+SEXP internal_cproject (SEXP collection, const CharacterVector& properties)
+{
+    if (api == NULL)
+        internal_cinit ("localhost", 56789);
+	       
+    return api->project (collection, properties);
+}
+
 // [[Rcpp::export]]
 void internal_cset (SEXP obj, const std::string& property, const RObject& value)
 {
@@ -108,3 +139,105 @@ SEXP internal_cget_indexed (SEXP obj, int ith)
 	       
     return api->get_indexed (obj, ith);
 }
+
+
+// [[Rcpp::export]]
+SEXP internal_cprepare (const std::string& classname, const std::string& method, SEXP argtypes)
+{
+    if (api == NULL)
+        internal_cinit ("localhost", 56789);
+	       
+    return api->prepare (classname, method, argtypes);
+}
+
+// [[Rcpp::export]]
+SEXP internal_cinvoke (int handle, const List& argv)
+{
+    if (api == NULL)
+        internal_cinit ("localhost", 56789);
+	       
+    return api->invoke (handle, argv);
+}
+
+// [[Rcpp::export]]
+SEXP internal_cchain (SEXP target, const IntegerVector& kinds, const CharacterVector& names, const List& argv)
+{
+    if (api == NULL)
+        internal_cinit ("localhost", 56789);
+
+    return api->chain (target, kinds, names, argv);
+}
+
+
+// [[Rcpp::export]]
+void internal_ccompress (int threshold)
+{
+    if (api == NULL)
+        internal_cinit ("localhost", 56789);
+
+    api->compress (threshold);
+}
+
+
+// [[Rcpp::export]]
+void internal_cbatch_begin ()
+{
+    if (api == NULL)
+        internal_cinit ("localhost", 56789);
+
+    api->begin_batch ();
+}
+
+// [[Rcpp::export]]
+SEXP internal_cbatch_end ()
+{
+    if (api == NULL)
+        internal_cinit ("localhost", 56789);
+
+    return api->end_batch ();
+}
+
+// [[Rcpp::export]]
+void internal_cbatch_abort ()
+{
+    if (api != NULL)
+        api->abort_batch ();
+}
+
+// [[Rcpp::export]]
+SEXP internal_cstats ()
+{
+    if (api == NULL)
+        return CLRStats().frame();
+
+    return api->stats().frame();
+}
+
+// [[Rcpp::export]]
+void internal_cstats_reset ()
+{
+    if (api != NULL)
+        api->stats().reset();
+}
+
+// [[Rcpp::export]]
+SEXP internal_creplay (const std::string& path, int times = 1)
+{
+    if (replayer == NULL)
+        replayer = new CLRApi ();
+
+    replayer->attach (new RReplayTransport (path, times));
+    return replayer->replay ();
+}
+
+// [[Rcpp::export]]
+int internal_cobjectid (SEXP obj)
+{
+    return CLRObjectRef::objectIdOf (obj);
+}
+
+// [[Rcpp::export]]
+SEXP internal_cclassname (SEXP obj)
+{
+    return CLRObjectRef::classnameOf (obj);
+}
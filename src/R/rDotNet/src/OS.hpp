@@ -1,9 +1,27 @@
 
+#ifndef RDOTNET_OS
+#define RDOTNET_OS
+
 #if defined(__WIN32__) || defined(_WIN32) || defined(WIN32) || defined(__CYGWIN32__) || defined(_MSC_VER)
 #define WINDOWS 1
 #else
 #define UNIX 1
 #endif
 
+#ifdef WINDOWS
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
+// id of the current process (changes in the child after a fork)
+inline int process_id ()
+{
+#ifdef WINDOWS
+    return _getpid();
+#else
+    return (int)getpid();
+#endif
+}
 
+#endif
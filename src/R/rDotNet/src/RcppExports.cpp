@@ -6,13 +6,19 @@
 using namespace Rcpp;
 
 // internal_cinit
-void internal_cinit(const std::string& host, int port);
-RcppExport SEXP _rDotNet_internal_cinit(SEXP hostSEXP, SEXP portSEXP) {
+void internal_cinit(const std::string& host, int port, bool nodelay, int sndbuf, int rcvbuf, bool quickack, bool keepalive, const std::string& capture);
+RcppExport SEXP _rDotNet_internal_cinit(SEXP hostSEXP, SEXP portSEXP, SEXP nodelaySEXP, SEXP sndbufSEXP, SEXP rcvbufSEXP, SEXP quickackSEXP, SEXP keepaliveSEXP, SEXP captureSEXP) {
 BEGIN_RCPP
     Rcpp::RNGScope rcpp_rngScope_gen;
     Rcpp::traits::input_parameter< const std::string& >::type host(hostSEXP);
     Rcpp::traits::input_parameter< int >::type port(portSEXP);
-    internal_cinit(host, port);
+    Rcpp::traits::input_parameter< bool >::type nodelay(nodelaySEXP);
+    Rcpp::traits::input_parameter< int >::type sndbuf(sndbufSEXP);
+    Rcpp::traits::input_parameter< int >::type rcvbuf(rcvbufSEXP);
+    Rcpp::traits::input_parameter< bool >::type quickack(quickackSEXP);
+    Rcpp::traits::input_parameter< bool >::type keepalive(keepaliveSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type capture(captureSEXP);
+    internal_cinit(host, port, nodelay, sndbuf, rcvbuf, quickack, keepalive, capture);
     return R_NilValue;
 END_RCPP
 }
@@ -102,9 +108,163 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// internal_cprepare
+SEXP internal_cprepare(const std::string& classname, const std::string& method, SEXP argtypes);
+RcppExport SEXP _rDotNet_internal_cprepare(SEXP classnameSEXP, SEXP methodSEXP, SEXP argtypesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type classname(classnameSEXP);
+    Rcpp::traits::input_parameter< const std::string& >::type method(methodSEXP);
+    Rcpp::traits::input_parameter< SEXP >::type argtypes(argtypesSEXP);
+    rcpp_result_gen = Rcpp::wrap(internal_cprepare(classname, method, argtypes));
+    return rcpp_result_gen;
+END_RCPP
+}
+// internal_cinvoke
+SEXP internal_cinvoke(int handle, const List& argv);
+RcppExport SEXP _rDotNet_internal_cinvoke(SEXP handleSEXP, SEXP argvSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type handle(handleSEXP);
+    Rcpp::traits::input_parameter< const List& >::type argv(argvSEXP);
+    rcpp_result_gen = Rcpp::wrap(internal_cinvoke(handle, argv));
+    return rcpp_result_gen;
+END_RCPP
+}
+// internal_cbatch_begin
+void internal_cbatch_begin();
+RcppExport SEXP _rDotNet_internal_cbatch_begin() {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    internal_cbatch_begin();
+    return R_NilValue;
+END_RCPP
+}
+// internal_cbatch_end
+SEXP internal_cbatch_end();
+RcppExport SEXP _rDotNet_internal_cbatch_end() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(internal_cbatch_end());
+    return rcpp_result_gen;
+END_RCPP
+}
+// internal_cbatch_abort
+void internal_cbatch_abort();
+RcppExport SEXP _rDotNet_internal_cbatch_abort() {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    internal_cbatch_abort();
+    return R_NilValue;
+END_RCPP
+}
+// internal_cstats
+SEXP internal_cstats();
+RcppExport SEXP _rDotNet_internal_cstats() {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    rcpp_result_gen = Rcpp::wrap(internal_cstats());
+    return rcpp_result_gen;
+END_RCPP
+}
+// internal_cstats_reset
+void internal_cstats_reset();
+RcppExport SEXP _rDotNet_internal_cstats_reset() {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    internal_cstats_reset();
+    return R_NilValue;
+END_RCPP
+}
+// internal_creplay
+SEXP internal_creplay(const std::string& path, int times);
+RcppExport SEXP _rDotNet_internal_creplay(SEXP pathSEXP, SEXP timesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< const std::string& >::type path(pathSEXP);
+    Rcpp::traits::input_parameter< int >::type times(timesSEXP);
+    rcpp_result_gen = Rcpp::wrap(internal_creplay(path, times));
+    return rcpp_result_gen;
+END_RCPP
+}
+// internal_ccompress
+void internal_ccompress(int threshold);
+RcppExport SEXP _rDotNet_internal_ccompress(SEXP thresholdSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< int >::type threshold(thresholdSEXP);
+    internal_ccompress(threshold);
+    return R_NilValue;
+END_RCPP
+}
+// internal_cobjectid
+int internal_cobjectid(SEXP obj);
+RcppExport SEXP _rDotNet_internal_cobjectid(SEXP objSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type obj(objSEXP);
+    rcpp_result_gen = Rcpp::wrap(internal_cobjectid(obj));
+    return rcpp_result_gen;
+END_RCPP
+}
+// internal_cclassname
+SEXP internal_cclassname(SEXP obj);
+RcppExport SEXP _rDotNet_internal_cclassname(SEXP objSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type obj(objSEXP);
+    rcpp_result_gen = Rcpp::wrap(internal_cclassname(obj));
+    return rcpp_result_gen;
+END_RCPP
+}
+// internal_cchain
+SEXP internal_cchain(SEXP target, const IntegerVector& kinds, const CharacterVector& names, const List& argv);
+RcppExport SEXP _rDotNet_internal_cchain(SEXP targetSEXP, SEXP kindsSEXP, SEXP namesSEXP, SEXP argvSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type target(targetSEXP);
+    Rcpp::traits::input_parameter< const IntegerVector& >::type kinds(kindsSEXP);
+    Rcpp::traits::input_parameter< const CharacterVector& >::type names(namesSEXP);
+    Rcpp::traits::input_parameter< const List& >::type argv(argvSEXP);
+    rcpp_result_gen = Rcpp::wrap(internal_cchain(target, kinds, names, argv));
+    return rcpp_result_gen;
+END_RCPP
+}
+// internal_cget_many
+SEXP internal_cget_many(SEXP obj, const CharacterVector& properties);
+RcppExport SEXP _rDotNet_internal_cget_many(SEXP objSEXP, SEXP propertiesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type obj(objSEXP);
+    Rcpp::traits::input_parameter< const CharacterVector& >::type properties(propertiesSEXP);
+    rcpp_result_gen = Rcpp::wrap(internal_cget_many(obj, properties));
+    return rcpp_result_gen;
+END_RCPP
+}
+// internal_cproject
+SEXP internal_cproject(SEXP collection, const CharacterVector& properties);
+RcppExport SEXP _rDotNet_internal_cproject(SEXP collectionSEXP, SEXP propertiesSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type collection(collectionSEXP);
+    Rcpp::traits::input_parameter< const CharacterVector& >::type properties(propertiesSEXP);
+    rcpp_result_gen = Rcpp::wrap(internal_cproject(collection, properties));
+    return rcpp_result_gen;
+END_RCPP
+}
 
 static const R_CallMethodDef CallEntries[] = {
-    {"_rDotNet_internal_cinit", (DL_FUNC) &_rDotNet_internal_cinit, 2},
+    {"_rDotNet_internal_cinit", (DL_FUNC) &_rDotNet_internal_cinit, 8},
     {"_rDotNet_internal_ctest_connection", (DL_FUNC) &_rDotNet_internal_ctest_connection, 2},
     {"_rDotNet_internal_cnew", (DL_FUNC) &_rDotNet_internal_cnew, 2},
     {"_rDotNet_internal_ccall_static", (DL_FUNC) &_rDotNet_internal_ccall_static, 3},
@@ -112,6 +272,20 @@ static const R_CallMethodDef CallEntries[] = {
     {"_rDotNet_internal_cget", (DL_FUNC) &_rDotNet_internal_cget, 2},
     {"_rDotNet_internal_cset", (DL_FUNC) &_rDotNet_internal_cset, 3},
     {"_rDotNet_internal_cget_indexed", (DL_FUNC) &_rDotNet_internal_cget_indexed, 2},
+    {"_rDotNet_internal_cprepare", (DL_FUNC) &_rDotNet_internal_cprepare, 3},
+    {"_rDotNet_internal_cinvoke", (DL_FUNC) &_rDotNet_internal_cinvoke, 2},
+    {"_rDotNet_internal_cbatch_begin", (DL_FUNC) &_rDotNet_internal_cbatch_begin, 0},
+    {"_rDotNet_internal_cbatch_end", (DL_FUNC) &_rDotNet_internal_cbatch_end, 0},
+    {"_rDotNet_internal_cbatch_abort", (DL_FUNC) &_rDotNet_internal_cbatch_abort, 0},
+    {"_rDotNet_internal_cstats", (DL_FUNC) &_rDotNet_internal_cstats, 0},
+    {"_rDotNet_internal_cstats_reset", (DL_FUNC) &_rDotNet_internal_cstats_reset, 0},
+    {"_rDotNet_internal_creplay", (DL_FUNC) &_rDotNet_internal_creplay, 2},
+    {"_rDotNet_internal_ccompress", (DL_FUNC) &_rDotNet_internal_ccompress, 1},
+    {"_rDotNet_internal_cobjectid", (DL_FUNC) &_rDotNet_internal_cobjectid, 1},
+    {"_rDotNet_internal_cclassname", (DL_FUNC) &_rDotNet_internal_cclassname, 1},
+    {"_rDotNet_internal_cchain", (DL_FUNC) &_rDotNet_internal_cchain, 4},
+    {"_rDotNet_internal_cget_many", (DL_FUNC) &_rDotNet_internal_cget_many, 2},
+    {"_rDotNet_internal_cproject", (DL_FUNC) &_rDotNet_internal_cproject, 2},
     {NULL, NULL, 0}
 };
 
@@ -0,0 +1,226 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#include "OS.hpp"
+
+#ifndef WINDOWS
+
+#include "ShmClient.hpp"
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <signal.h>
+#include <sched.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+
+// spins before yielding (none on a single cpu), then yields before sleeping, while waiting on the server
+static const int SpinLimit = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 1000 : 0;
+static const int YieldLimit = SpinLimit + 5000;
+
+
+// determine if connected
+bool RShmClient::is_connected()
+{
+    return _base != NULL;
+}
+
+
+// read available bytes from the reply ring, waiting for at least 1 byte
+int RShmClient::read (byte* buffer, int bufferlen, int retries)
+{
+    if (_base == NULL)
+        return 0;
+
+    uint64_t* phead = position (OffReplyHead);
+    uint64_t* ptail = position (OffReplyTail);
+    byte* ring = _base + HeaderSize + _capacity;
+
+    uint64_t tail = *ptail;
+    uint64_t head = __atomic_load_n (phead, __ATOMIC_ACQUIRE);
+    for (int spins = 0 ; head == tail ; spins++)
+    {
+        if (!pause (spins))
+	    return 0;
+	head = __atomic_load_n (phead, __ATOMIC_ACQUIRE);
+    }
+
+    size_t n = (size_t)min ((uint64_t)bufferlen, head - tail);
+    size_t start = (size_t)(tail & (_capacity - 1));
+    size_t first = min (n, (size_t)_capacity - start);
+
+    memcpy (buffer, ring + start, first);
+    memcpy (buffer + first, ring, n - first);
+
+    __atomic_store_n (ptail, tail + n, __ATOMIC_RELEASE);
+    return (int)n;
+}
+
+
+// write data to the request ring, waiting for space as needed
+int RShmClient::write (const byte* buffer, int len, int retries)
+{
+    if (_base == NULL)
+        return 0;
+
+    uint64_t* phead = position (OffRequestHead);
+    uint64_t* ptail = position (OffRequestTail);
+    byte* ring = _base + HeaderSize;
+
+    size_t done = 0;
+    while (done < (size_t)len)
+    {
+        uint64_t head = *phead;
+	uint64_t free = _capacity - (head - __atomic_load_n (ptail, __ATOMIC_ACQUIRE));
+	for (int spins = 0 ; free == 0 ; spins++)
+	{
+	    if (!pause (spins))
+	        return (int)done;
+	    free = _capacity - (head - __atomic_load_n (ptail, __ATOMIC_ACQUIRE));
+	}
+
+	size_t n = (size_t)min ((uint64_t)(len - done), free);
+	size_t start = (size_t)(head & (_capacity - 1));
+	size_t first = min (n, (size_t)_capacity - start);
+
+	memcpy (ring + start, buffer + done, first);
+	memcpy (ring, buffer + done + first, n - first);
+
+	__atomic_store_n (phead, head + n, __ATOMIC_RELEASE);
+	done += n;
+    }
+
+    return len;
+}
+
+
+// close connection, handing the rings back to the server
+void RShmClient::close ()
+{
+    if (_base == NULL)
+        return;
+
+    __atomic_store_n (field (OffState), StateClosed, __ATOMIC_RELEASE);
+    munmap (_base, _size);
+    _base = NULL;
+}
+
+
+// unmap inherited rings without marking the connection closed
+void RShmClient::abandon ()
+{
+    if (_base == NULL)
+        return;
+
+    munmap (_base, _size);
+    _base = NULL;
+}
+
+
+// map file and attach to rings
+void RShmClient::connect (const std::string& path)
+{
+    int fd = ::open (path.c_str(), O_RDWR);
+    if (fd < 0)
+        throw runtime_error("unable to open CLR shared memory: " + path);
+
+    struct stat st;
+    if (fstat (fd, &st) < 0 || st.st_size < HeaderSize)
+        { ::close (fd); throw runtime_error("CLR shared memory is not initialized: " + path); }
+
+    void* mem = mmap (NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close (fd);
+    if (mem == MAP_FAILED)
+        throw runtime_error("unable to map CLR shared memory: " + path);
+
+    _base = (byte*)mem;
+    _size = (size_t)st.st_size;
+    _capacity = (uint64_t)*field (OffCapacity);
+
+    const char* error = NULL;
+    if (__atomic_load_n (field (OffMagic), __ATOMIC_ACQUIRE) != Magic || *field (OffVersion) != Version)
+        error = "CLR shared memory has unknown format: ";
+    else if (_capacity == 0 || (_capacity & (_capacity - 1)) != 0 || _size < HeaderSize + 2 * _capacity)
+        error = "CLR shared memory has bad ring capacity: ";
+    else if (::kill (*field (OffServerPid), 0) < 0 && errno == ESRCH)
+        error = "CLR server for shared memory is not running: ";
+
+    // wait briefly for the server to release the rings from a previous client
+    for (int i = 0 ; error == NULL && i < 1000 && __atomic_load_n (field (OffState), __ATOMIC_ACQUIRE) == StateClosed ; i++)
+    {
+        struct timespec delay = { 0, 1000000 };
+	nanosleep (&delay, NULL);
+    }
+
+    // claim the rings (the server only touches them once connected)
+    int32_t expected = StateIdle;
+    if (error == NULL && !__atomic_compare_exchange_n (field (OffState), &expected, StateConnecting, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE))
+        error = "CLR shared memory is in use by another client: ";
+
+    if (error != NULL)
+    {
+        munmap (_base, _size);
+	_base = NULL;
+	throw runtime_error(error + path);
+    }
+
+    *field (OffClientPid) = (int32_t)getpid();
+    __atomic_store_n (position (OffRequestHead), (uint64_t)0, __ATOMIC_RELAXED);
+    __atomic_store_n (position (OffRequestTail), (uint64_t)0, __ATOMIC_RELAXED);
+    __atomic_store_n (position (OffReplyHead), (uint64_t)0, __ATOMIC_RELAXED);
+    __atomic_store_n (position (OffReplyTail), (uint64_t)0, __ATOMIC_RELAXED);
+    __atomic_store_n (field (OffState), StateConnected, __ATOMIC_RELEASE);
+}
+
+
+// back off while waiting on the server, returning false if the server has gone away
+bool RShmClient::pause (int spins)
+{
+    if (spins < SpinLimit)
+        return true;
+
+    if (spins < YieldLimit)
+    {
+        sched_yield();
+	return true;
+    }
+
+    struct timespec delay = { 0, 50000 };
+    nanosleep (&delay, NULL);
+
+    // periodically verify that the server is still alive
+    if ((spins - YieldLimit) % 2000 == 1999 && ::kill (*field (OffServerPid), 0) < 0 && errno == ESRCH)
+        return false;
+
+    return true;
+}
+
+#endif
@@ -0,0 +1,110 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#ifndef RSHM_CLIENT
+#define RSHM_CLIENT
+
+#include <cstdlib>
+#include <string>
+#include <stdint.h>
+#include "Transport.hpp"
+
+
+//
+// Shared memory client: a pair of single-producer / single-consumer rings in a file mapped
+// by the CLR server (see SharedMemoryStream.cs for the layout)
+//
+class RShmClient : public RTransport
+{
+  public:
+
+    // header layout
+    static const int32_t Magic           = 0x4d485344;
+    static const int32_t Version         = 1;
+    static const int     HeaderSize      = 4096;
+
+    static const int     OffMagic        = 0;
+    static const int     OffVersion      = 4;
+    static const int     OffCapacity     = 8;
+    static const int     OffState        = 12;
+    static const int     OffServerPid    = 16;
+    static const int     OffClientPid    = 20;
+    static const int     OffRequestHead  = 64;
+    static const int     OffRequestTail  = 128;
+    static const int     OffReplyHead    = 192;
+    static const int     OffReplyTail    = 256;
+
+    // connection states
+    static const int32_t StateIdle       = 0;
+    static const int32_t StateConnected  = 1;
+    static const int32_t StateClosed     = 2;
+    static const int32_t StateConnecting = 3;
+
+    RShmClient (const std::string& path)
+      : _path(path), _base(NULL), _size(0), _capacity(0)
+    {
+      connect (path);
+    }
+
+    ~RShmClient ()
+    {
+      close ();
+    }
+
+    // determine if connected
+    bool is_connected ();
+
+    // read data into buffer 
+    int read (byte* buffer, int bufferlen, int retries = 0);
+
+    // write data 
+    int write (const byte* buffer, int len, int retries = 0);
+
+    // close connection
+    void close ();
+
+    // unmap inherited rings without marking the connection closed
+    void abandon ();
+
+  private:
+
+    // map file and attach to rings
+    void connect (const std::string& path);
+
+    // back off while waiting on the server, returning false if the server has gone away
+    bool pause (int spins);
+
+    int32_t* field (int offset)
+      { return (int32_t*)(_base + offset); }
+
+    uint64_t* position (int offset)
+      { return (uint64_t*)(_base + offset); }
+
+  private:
+      std::string  _path;
+      byte*        _base;
+      size_t       _size;
+      uint64_t     _capacity;
+};
+
+#endif
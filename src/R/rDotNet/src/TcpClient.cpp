@@ -33,7 +33,9 @@
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <netdb.h> 
+#include <sys/un.h>
 #endif
 
 #include <Rcpp.h>
@@ -41,11 +43,23 @@
 #include <stdexcept>
 #include <iostream>
 #include <sstream>
+#include <cstring>
+#include <map>
 
 using namespace std;
 using namespace Rcpp;
 
 
+// prefix of host names denoting a unix domain socket path, as in unix:///tmp/clr.sock
+static const std::string UnixScheme = "unix://";
+
+// determine whether host refers to a unix domain socket
+static bool is_unix_endpoint (const std::string& host)
+{
+    return host.compare (0, UnixScheme.size(), UnixScheme) == 0;
+}
+
+
 // determine if is connected based on socket
 bool RTcpClient::is_connected()
 {
@@ -64,7 +78,14 @@ int RTcpClient::read (byte* buffer, int bufferlen, int retries)
 	int n = ::recv (_sock, (void*)buffer, bufferlen, 0);
 #endif	
 	if (n >= 0)
+	{
+#ifdef TCP_QUICKACK
+	    // linux falls back to delayed acks, so quick ack needs to be re-armed after each read
+	    if (_inet && _options.quickack)
+	        { int on = 1; ::setsockopt (_sock, IPPROTO_TCP, TCP_QUICKACK, &on, sizeof(on)); }
+#endif
 	    return n;
+	}
 	else
 	    close();
     }
@@ -113,6 +134,17 @@ void RTcpClient::close ()
 }
   
 
+// close inherited socket descriptor without shutting down the connection
+void RTcpClient::abandon ()
+{
+#ifndef WINDOWS
+    if (_sock >= 0)
+        ::close (_sock);
+#endif
+    _sock = -1;
+}
+
+
 // reconnect if connection was broken 
 void RTcpClient::reconnect ()
 {
@@ -123,21 +155,124 @@ void RTcpClient::reconnect ()
 }
 
 
+
+// resolved addresses by host:port, so that reconnects do not repeat the DNS lookup
+struct ResolvedAddress
+{
+    struct sockaddr_storage  addr;
+    int                      addrlen;
+    int                      family;
+};
+
+static std::map<std::string, ResolvedAddress> resolved;
+
+
+// close socket without reporting
+static void close_socket (int sock)
+{
 #ifdef WINDOWS
+    closesocket (sock);
+#else
+    ::close (sock);
+#endif
+}
+
+
+// set integer valued socket option
+static void set_option (int sock, int level, int option, int value)
+{
+    ::setsockopt (sock, level, option, (const char*)((void*)&value), sizeof(value));
+}
+
+
+// apply socket options (buffer sizes must be set before connecting to affect the TCP window)
+void RTcpClient::configure ()
+{
+    if (_options.sndbuf > 0)
+        set_option (_sock, SOL_SOCKET, SO_SNDBUF, _options.sndbuf);
+    if (_options.rcvbuf > 0)
+        set_option (_sock, SOL_SOCKET, SO_RCVBUF, _options.rcvbuf);
+
+    if (!_inet)
+        return;
+
+    if (_options.nodelay)
+        set_option (_sock, IPPROTO_TCP, TCP_NODELAY, 1);
+    if (_options.keepalive)
+        set_option (_sock, SOL_SOCKET, SO_KEEPALIVE, 1);
+#ifdef TCP_QUICKACK
+    if (_options.quickack)
+        set_option (_sock, IPPROTO_TCP, TCP_QUICKACK, 1);
+#endif
+}
+
+
+// create socket and attempt connection to the given address
+bool RTcpClient::connect_to (const struct sockaddr* addr, int addrlen, int family)
+{
+#ifdef WINDOWS
+    SOCKET sock = socket(family, SOCK_STREAM, IPPROTO_TCP);
+    if (sock == INVALID_SOCKET)
+        { WSACleanup(); throw runtime_error("unable to create socket"); }
+#else
+    int sock = socket(family, SOCK_STREAM, IPPROTO_TCP);
+    if (sock < 0)
+        throw runtime_error("unable to create socket");
+#endif
+
+    _sock = (int)sock;
+    _inet = true;
+    configure();
+
+    int err = ::connect (_sock, addr, addrlen);
+    if (err < 0)
+    {
+        close_socket (_sock);
+	_sock = -1;
+	return false;
+    }
+
+    return true;
+}
+
 
 // connect  
 void RTcpClient::connect (const std::string& host, int port)
 {
-    struct addrinfo hints;
-    WSADATA wsaData;
+    if (is_unix_endpoint (host))
+    {
+#ifdef WINDOWS
+        throw runtime_error("unix domain sockets are not supported on windows");
+#else
+        connect_unix (host.substr (UnixScheme.size()));
+	return;
+#endif
+    }
 
+#ifdef WINDOWS
     // magic needed to initialize the winsock API (usual WIN32 stupid internals exposure)
-    int err = WSAStartup(MAKEWORD(2,2), &wsaData);
-    if (err != 0)
+    WSADATA wsaData;
+    int wsaerr = WSAStartup(MAKEWORD(2,2), &wsaData);
+    if (wsaerr != 0)
         throw std::runtime_error("failed to initialize socket api");
+#endif
+
+    std::stringstream key;
+    key << host << ":" << port;
+
+    // try previously resolved address first, resolving again if it no longer connects
+    std::map<std::string, ResolvedAddress>::iterator cached = resolved.find (key.str());
+    if (cached != resolved.end())
+    {
+        ResolvedAddress& address = cached->second;
+        if (connect_to ((struct sockaddr*)&address.addr, address.addrlen, address.family))
+	    return;
+	resolved.erase (cached);
+    }
 
     // setup type of connect
-    ZeroMemory (&hints, sizeof(hints));
+    struct addrinfo hints;
+    memset((void *)&hints, 0, sizeof(hints));
     hints.ai_family = AF_UNSPEC;
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_protocol = IPPROTO_TCP;
@@ -145,60 +280,55 @@ void RTcpClient::connect (const std::string& host, int port)
     // resolve the host
     struct addrinfo* hostlist;
     char portname[32];
-    char* hostname = (char*)((void*)host.c_str());
-
     sprintf(portname, "%d", port);
 
-    err  = getaddrinfo(hostname, portname, &hints, &hostlist);
+    int err = getaddrinfo(host.c_str(), portname, &hints, &hostlist);
     if (err != 0)
-        { WSACleanup(); throw std::runtime_error("failed to connect to DNS"); }
+        throw runtime_error("unable to lookup or locate CLR host on DNS");
 
     // attempt to connect to each alternative for the host in turn
-    struct addrinfo* addr = NULL;
-    for (addr = hostlist; addr != NULL ; addr = addr->ai_next)
+    for (struct addrinfo* addr = hostlist; addr != NULL ; addr = addr->ai_next)
     {
-        // create socket
-        SOCKET sock = socket(addr->ai_family, addr->ai_socktype, addr->ai_protocol);
-	if (sock == INVALID_SOCKET)
-	    { WSACleanup(); throw runtime_error("unable to create socket"); }
-        else
-  	    _sock = sock;
-
-	// attempt to connect
-	err = ::connect (_sock, addr->ai_addr, (int)addr->ai_addrlen);
-	if (err == SOCKET_ERROR)
-	{
-	    closesocket(_sock);
-	    _sock = -1;
-	} else
-	    break;
+        if (!connect_to (addr->ai_addr, (int)addr->ai_addrlen, addr->ai_family))
+	    continue;
+
+	ResolvedAddress address;
+	memcpy ((void*)&address.addr, addr->ai_addr, addr->ai_addrlen);
+	address.addrlen = (int)addr->ai_addrlen;
+	address.family = addr->ai_family;
+	resolved[key.str()] = address;
+	break;
     }
 
     // free up host resolution list
     freeaddrinfo(hostlist);
+
+    if (_sock < 0)
+        throw runtime_error("unable to connect to CLR server at " + key.str());
 }
 
-#else
 
-// connect  
-void RTcpClient::connect (const std::string& host, int port)
+#ifndef WINDOWS
+
+// connect to unix domain socket at given path
+void RTcpClient::connect_unix (const std::string& path)
 {
+    struct sockaddr_un addr;
+    if (path.size() >= sizeof(addr.sun_path))
+        throw runtime_error("unix socket path is too long: " + path);
+
     // create socket
-    _sock = socket(AF_INET, SOCK_STREAM, 0);
+    _sock = socket(AF_UNIX, SOCK_STREAM, 0);
     if (_sock < 0)
         throw runtime_error("unable to create socket");
 
-    // lookup host address
-    struct hostent* server = ::gethostbyname(host.c_str());
-    if (server == NULL)
-        throw runtime_error("unable to lookup or locate CLR host on DNS");
+    _inet = false;
+    configure();
 
     // create address
-    struct sockaddr_in addr;
     memset((void *)&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    memcpy((void *)&addr.sin_addr.s_addr, (void *)server->h_addr, server->h_length);
-    addr.sin_port = htons(port);
+    addr.sun_family = AF_UNIX;
+    memcpy((void *)addr.sun_path, path.c_str(), path.size());
 
     // create connection
     int err = ::connect (_sock, (struct sockaddr *)&addr, sizeof(addr));
@@ -206,4 +336,5 @@ void RTcpClient::connect (const std::string& host, int port)
         close();
 }
 
+
 #endif
@@ -27,19 +27,21 @@
 
 #include <cstdlib>
 #include <string>
+#include "OS.hpp"
+#include "Transport.hpp"
 
-typedef unsigned char byte;
+struct sockaddr;
 
 
 //
-// Simple TCP stream client
+// Simple TCP stream client (host may also be unix:///path for a unix domain socket)
 //
-class RTcpClient
+class RTcpClient : public RTransport
 {
   public:
 
-    RTcpClient (const std::string& host, int port)
-      : _hostname(host), _port(port), _sock(-1)
+    RTcpClient (const std::string& host, int port, const RSocketOptions& options = RSocketOptions())
+      : _hostname(host), _port(port), _sock(-1), _inet(false), _options(options)
     {
       connect (host, port);
     }
@@ -56,6 +58,9 @@ class RTcpClient
     // close socket
     void close ();
 
+    // close inherited socket descriptor without shutting down the connection
+    void abandon ();
+
   private:
 
     // reconnect if connection was broken 
@@ -63,11 +68,21 @@ class RTcpClient
 
     // connect  
     void connect (const std::string& host, int port);
+    // create socket and attempt connection to the given address
+    bool connect_to (const struct sockaddr* addr, int addrlen, int family);
+    // apply socket options
+    void configure ();
+#ifndef WINDOWS
+    // connect to unix domain socket
+    void connect_unix (const std::string& path);
+#endif
 
   private:
       std::string  _hostname;
       int          _port;
       int          _sock;
+      bool         _inet;
+      RSocketOptions _options;
 };
 
 #endif
@@ -0,0 +1,55 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#include "Transport.hpp"
+#include "TcpClient.hpp"
+#include "ShmClient.hpp"
+#include "OS.hpp"
+
+#include <stdexcept>
+
+using namespace std;
+
+
+// prefix of host names denoting a shared memory file, as in shm:///dev/shm/clr
+static const std::string ShmScheme = "shm://";
+
+
+// open transport for the given endpoint
+RTransport* RTransport::open (const std::string& host, int port, const RSocketOptions& options)
+{
+    if (!is_shm (host))
+        return new RTcpClient (host, port, options);
+
+#ifdef WINDOWS
+    throw runtime_error("shared memory transport is not supported on windows");
+#else
+    return new RShmClient (host.substr (ShmScheme.size()));
+#endif
+}
+
+// determine whether the endpoint is a shared memory file
+bool RTransport::is_shm (const std::string& host)
+{
+    return host.compare (0, ShmScheme.size(), ShmScheme) == 0;
+}
@@ -0,0 +1,79 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#ifndef RTRANSPORT
+#define RTRANSPORT
+
+#include <cstdlib>
+#include <string>
+
+typedef unsigned char byte;
+
+
+//
+// Socket options applied on connect (defaults favour low latency for small requests)
+//
+struct RSocketOptions
+{
+    RSocketOptions ()
+      : nodelay(true), quickack(true), keepalive(true), sndbuf(0), rcvbuf(0) {}
+
+    bool  nodelay;     // disable Nagle's algorithm (TCP_NODELAY)
+    bool  quickack;    // acknowledge immediately rather than delaying (TCP_QUICKACK, linux only)
+    bool  keepalive;   // probe idle connections to detect a dead peer (SO_KEEPALIVE)
+    int   sndbuf;      // send buffer size in bytes (SO_SNDBUF), or 0 for the system default
+    int   rcvbuf;      // receive buffer size in bytes (SO_RCVBUF), or 0 for the system default
+};
+
+
+//
+// Byte stream transport to the CLR (TCP / unix socket or shared memory)
+//
+class RTransport
+{
+  public:
+
+    virtual ~RTransport() { }
+
+    // open transport for the given endpoint: host, unix:///path or shm:///path
+    static RTransport* open (const std::string& host, int port, const RSocketOptions& options = RSocketOptions());
+    // determine whether the endpoint is a shared memory file (shm:///path)
+    static bool is_shm (const std::string& host);
+
+    // determine if connected
+    virtual bool is_connected () = 0;
+
+    // read data into buffer 
+    virtual int read (byte* buffer, int bufferlen, int retries = 0) = 0;
+
+    // write data 
+    virtual int write (const byte* buffer, int len, int retries = 0) = 0;
+
+    // close transport
+    virtual void close () = 0;
+
+    // let go of a connection inherited from the parent process after a fork, leaving it intact for the parent
+    virtual void abandon () = 0;
+};
+
+#endif
@@ -24,8 +24,12 @@
 #define BUFFERED_SOCKET_READER
 
 #include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
 #include <Rcpp.h>
-#include "TcpClient.hpp"
+#include "Transport.hpp"
 
 using namespace std;
 using namespace Rcpp;
@@ -45,14 +49,22 @@ class BufferedSocketReader
 {
   public:
 
-    BufferedSocketReader (RTcpClient* tcp, int buflen = 4*8192)
-      : _sock(tcp), _buffer(NULL), _buflen(buflen), _pos(0), _len(0), _eof(false)
+    // bit array flag: a bitset of NA positions follows the values
+    static const char BitArrayNA = 1;
+    // float32 array encoding of NA (a NaN carrying R's NA payload)
+    static const uint32_t Float32NA = 0x7fc007a2;
+
+    BufferedSocketReader (RTransport* tcp, int buflen = 4*8192)
+      : _sock(tcp), _buffer(NULL), _buflen(buflen), _pos(0), _len(0), _eof(false), _read(0),
+	_overlaid(false), _outer(NULL), _outerpos(0), _outerlen(0)
     {
         _buffer = new byte[buflen];
     }
 
     ~BufferedSocketReader ()
     {
+        if (_overlaid)
+	    pop();
         delete[] _buffer;
     }
 
@@ -62,7 +74,7 @@ class BufferedSocketReader
         if (_eof)
 	    return true;
 	else if (_pos < _len)
-	    return true;
+	    return false;
 	else {
 	    replenish(1);
 	    _eof = _len == 0;
@@ -88,15 +100,37 @@ class BufferedSocketReader
         int len = read_int32();
 
 	// read string text
-	char* tmp = new char[len];
-	for (int i = 0 ; i < len ; i++)
-	    tmp[i] = read_byte();
+	std::string newstr (len, '\0');
+	if (len > 0)
+	    read_bytes (&newstr[0], (size_t)len);
 
-	std::string newstr (tmp, len);
-	delete[] tmp;
 	return newstr;
     }
 
+    // read a string as a UTF-8 CHARSXP, created directly from the buffer where possible
+    SEXP read_charsxp ()
+    {
+        // read string length (-1 for NA, within string arrays)
+        int len = read_int32();
+	if (len < 0)
+	    return NA_STRING;
+
+	// make sure the whole string is buffered, unless larger than the buffer
+	if ((_pos+len) > _len && len <= _buflen)
+	    replenish(len);
+
+	if ((_pos+len) <= _len)
+	{
+	    SEXP s = Rf_mkCharLenCE (reinterpret_cast<const char*>(_buffer + _pos), len, CE_UTF8);
+	    _pos += len;
+	    return s;
+	}
+
+	std::string text (len, '\0');
+	read_bytes (&text[0], (size_t)len);
+	return Rf_mkCharLenCE (text.data(), len, CE_UTF8);
+    }
+
     // read int16 
     int16_t read_int16 ()
     {
@@ -150,71 +184,274 @@ class BufferedSocketReader
     }
 
     // read a boolean array
-    LogicalVector* read_bool_array ()
+    SEXP read_bool_array ()
     {
         // read array length
         int len = read_int32();
 
 	// read values into vector
-	LogicalVector* vec = new LogicalVector(len);
+	SEXP vec = Rf_allocVector (LGLSXP, len);
+	int* values = LOGICAL(vec);
 	for (int i = 0 ; i < len ; i++)
-	    (*vec)[i] = read_byte() != (char)0;
+	    values[i] = read_byte() != (char)0;
+
+	return vec;
+    }
+
+    // read a packed bit array, with NA positions following the values if flagged
+    SEXP read_bit_array ()
+    {
+        // read array length and flags
+        int len = read_int32();
+	char flags = read_byte();
+
+	// unpack values directly into vector storage
+	SEXP vec = Rf_allocVector (LGLSXP, len);
+	read_bits (LOGICAL(vec), len, false);
+	if (flags & BitArrayNA)
+	    read_bits (LOGICAL(vec), len, true);
 
 	return vec;
     }
 
     // read a float64 array
-    NumericVector* read_float64_array ()
+    SEXP read_float64_array ()
     {
         // read array length
         int len = read_int32();
 
-	// read values into vector
-	NumericVector* vec = new NumericVector(len);
-	for (int i = 0 ; i < len ; i++)
-	  (*vec)[i] = read_float64();
+	// read values directly into vector storage
+	SEXP vec = Rf_allocVector (REALSXP, len);
+	read_bytes (REAL(vec), (size_t)len * sizeof(double));
+
+	return vec;
+    }
+
+    // read a float32 array into a float64 vector (with NA preserved)
+    SEXP read_float32_array ()
+    {
+        // read array length
+        int len = read_int32();
+
+	SEXP vec = Rf_allocVector (REALSXP, len);
+	double* values = REAL(vec);
+
+	float chunk[2048];
+	for (int i = 0 ; i < len ; )
+	{
+	    int n = std::min (2048, len - i);
+	    read_bytes (chunk, n * sizeof(float));
+	    for (int k = 0 ; k < n ; k++)
+	        values[i+k] = chunk[k];
+	    for (int k = 0 ; k < n ; k++)
+	        if (std::isnan (chunk[k]) && is_float32_na (chunk[k])) values[i+k] = NA_REAL;
+
+	    i += n;
+	}
 
 	return vec;
     }
 
     // read a int32 array
-    IntegerVector* read_int32_array ()
+    SEXP read_int32_array ()
     {
         // read array length
         int len = read_int32();
 
-	// read values into vector
-	IntegerVector* vec = new IntegerVector(len);
-	for (int i = 0 ; i < len ; i++)
-	  (*vec)[i] = read_int32();
+	// read values directly into vector storage
+	SEXP vec = Rf_allocVector (INTSXP, len);
+	read_bytes (INTEGER(vec), (size_t)len * sizeof(int32_t));
+
+	return vec;
+    }
+
+    // read a byte array
+    SEXP read_byte_array ()
+    {
+        // read array length
+        int len = read_int32();
+
+	// read values directly into vector storage
+	SEXP vec = Rf_allocVector (RAWSXP, len);
+	read_bytes (RAW(vec), (size_t)len);
+
+	return vec;
+    }
+
+    // read a int64 array (into double storage, as with bit64 integer64 vectors)
+    SEXP read_int64_array ()
+    {
+        // read array length
+        int len = read_int32();
+
+	// read values directly into vector storage
+	SEXP vec = Rf_allocVector (REALSXP, len);
+	read_bytes (REAL(vec), (size_t)len * sizeof(int64_t));
 
 	return vec;
     }
 
     // read a string array
-    CharacterVector* read_string_array ()
+    SEXP read_string_array ()
     {
         // read array length
         int len = read_int32();
 
-	// read values into vector
-	CharacterVector* vec = new CharacterVector(len);
+	// read values into vector (protected while the strings are allocated)
+	Rcpp::Shield<SEXP> vec (Rf_allocVector (STRSXP, len));
 	for (int i = 0 ; i < len ; i++)
-	  (*vec)[i] = read_string();
+	    SET_STRING_ELT (vec, i, read_charsxp());
 
 	return vec;
     }
 
+    // unpack a bitset (lsb first) 64 values to a word, either as TRUE/FALSE or marking NA positions
+    void read_bits (int* values, int len, bool na)
+    {
+	uint64_t words[512];
+	size_t remaining = ((size_t)len + 7) / 8;
+
+	for (int i = 0 ; i < len ; )
+	{
+	    size_t nbytes = std::min (remaining, sizeof(words));
+	    words[(nbytes-1) / sizeof(uint64_t)] = 0;
+	    read_bytes (words, nbytes);
+	    remaining -= nbytes;
+
+	    int nwords = (int)((nbytes + 7) / 8);
+	    for (int w = 0 ; w < nwords ; w++)
+	    {
+		int n = std::min (64, len - i);
+		uint64_t word = words[w];
+		if (na)
+		{
+		    for (int k = 0 ; k < n ; k++)
+			values[i+k] = ((word >> k) & 1) ? NA_LOGICAL : values[i+k];
+		}
+		else
+		{
+		    for (int k = 0 ; k < n ; k++)
+			values[i+k] = (int)((word >> k) & 1);
+		}
+		i += n;
+	    }
+	}
+    }
+
+    // read a block of raw bytes into the given memory
+    void read_bytes (void* dst, size_t nbytes)
+    {
+        byte* out = reinterpret_cast<byte*>(dst);
+
+	// copy whatever is already buffered
+	size_t buffered = min ((size_t)(_len - _pos), nbytes);
+	memcpy (out, _buffer + _pos, buffered);
+	_pos += buffered;
+	out += buffered;
+	nbytes -= buffered;
+
+	if (nbytes == 0)
+	    return;
+
+	// end of a pushed block: continue with the stream
+	if (_overlaid)
+	{
+	    pop();
+	    read_bytes (out, nbytes);
+	    return;
+	}
+
+	// small residual: go through the buffer so that we read ahead
+	if (nbytes < (size_t)_buflen)
+	{
+	    replenish ((int)nbytes);
+	    if ((size_t)_len < nbytes)
+	        throw ReadStreamTerminatedException();
+
+	    memcpy (out, _buffer, nbytes);
+	    _pos = (int)nbytes;
+	    return;
+	}
+
+	// large residual: receive directly into the destination, bypassing the buffer
+	while (nbytes > 0)
+	{
+	    int amount = (int)min (nbytes, (size_t)(1 << 30));
+	    int r = _sock->read (out, amount);
+	    if (r <= 0)
+	        throw ReadStreamTerminatedException();
+
+	    _read += r;
+
+	    out += r;
+	    nbytes -= r;
+	}
+    }
+
     void close ()
     {
        _sock->close();
     }
 
+    // total # of bytes consumed from the stream (excluding those read ahead)
+    uint64_t bytes () const
+    {
+        if (_overlaid)
+	    return _read - (_outerlen - _outerpos);
+	else
+	    return _read - (_len - _pos);
+    }
+
+    // read the given bytes (e.g. a decompressed value) before continuing with the stream
+    void push (std::vector<byte>& data)
+    {
+        if (_overlaid)
+	{
+	    if (_pos < _len)
+	        throw std::runtime_error ("BufferedSocketReader: cannot push a block within a pushed block");
+	    pop();
+	}
+
+	_block.swap (data);
+	_outer = _buffer;
+	_outerpos = _pos;
+	_outerlen = _len;
+
+	_buffer = _block.data();
+	_pos = 0;
+	_len = (int)_block.size();
+	_overlaid = true;
+    }
+
 
   private:
 
+    // determine whether float is the float32 encoding of NA
+    static bool is_float32_na (float v)
+    {
+        uint32_t bits;
+	memcpy (&bits, &v, sizeof(float));
+	return bits == Float32NA;
+    }
+
+    // return to the stream once a pushed block is consumed
+    void pop ()
+    {
+        _buffer = _outer;
+	_pos = _outerpos;
+	_len = _outerlen;
+	_overlaid = false;
+    }
+
     void replenish (int n)
     {
+        if (_overlaid)
+	{
+	    if (_pos < _len)
+	        throw std::runtime_error ("BufferedSocketReader: value extends past the end of its block");
+	    pop();
+	}
+
         // move residual to start of buffer
         int residual = _len - _pos;
         memcpy(_buffer, _buffer+_pos, residual);
@@ -231,17 +468,25 @@ class BufferedSocketReader
 	    read = max(r, 0);
 	    
 	    _len += read;
+	    _read += read;
 	    total += read;
 	}
     }
   
   private:
-    RTcpClient* _sock; 
+    RTransport* _sock; 
     byte*       _buffer;
     int         _buflen;
     int         _pos;
     int         _len;
     bool        _eof;
+    uint64_t    _read;
+
+    bool              _overlaid;
+    std::vector<byte> _block;
+    byte*             _outer;
+    int               _outerpos;
+    int               _outerlen;
 };
 
 #endif
@@ -24,9 +24,12 @@
 #define BUFFERED_SOCKET_WRITER
 
 #include <cstdlib>
+#include <algorithm>
+#include <cmath>
+#include <vector>
 #include <stdexcept>
 #include <Rcpp.h>
-#include "TcpClient.hpp"
+#include "Transport.hpp"
 
 using namespace std;
 using namespace Rcpp;
@@ -43,14 +46,21 @@ class BufferedSocketWriter
 {
   public:
 
-    BufferedSocketWriter (RTcpClient* tcp, int buflen = 8192)
-      : _sock(tcp), _buffer(NULL), _buflen(buflen), _len(0)
+    // bit array flag: a bitset of NA positions follows the values
+    static const char BitArrayNA = 1;
+    // float32 array encoding of NA (a NaN carrying R's NA payload)
+    static const uint32_t Float32NA = 0x7fc007a2;
+
+    BufferedSocketWriter (RTransport* tcp, int buflen = 8192)
+      : _sock(tcp), _buffer(NULL), _buflen(buflen), _len(0), _written(0), _diverted(false), _outer(NULL), _outerlen(0), _outercap(0)
     {
         _buffer = new byte[buflen];
     }
 
     ~BufferedSocketWriter ()
     {
+        if (_diverted)
+	    end_block();
         delete[] _buffer;
     }
 
@@ -127,9 +137,7 @@ class BufferedSocketWriter
     {
         int len = v.length();
         write_int32(len);
-
-	for (int i = 0 ; i < len ; i++)
-	    write_byte(v[i]);  
+	write_bytes (v.data(), (size_t)len);
     }
 
     // write string 
@@ -137,49 +145,189 @@ class BufferedSocketWriter
     {
         int len = strlen(v);
         write_int32(len);
+	write_bytes (v, (size_t)len);
+    }
 
-	for (int i = 0 ; i < len ; i++)
-	    write_byte(v[i]);  
+    // write a CHARSXP as UTF-8 (a no-op for ASCII and UTF-8 strings), NA as length -1 (null)
+    void write_charsxp (SEXP s)
+    {
+        if (s == NA_STRING)
+	    write_int32(-1);
+	else
+	    write_string(Rf_translateCharUTF8 (s));
     }
 
-    // write bool vector 
-    void write_bool_array (const LogicalVector& v)
+    // write bool vector (one byte per value)
+    void write_bool_array (SEXP v)
     {
-        int len = v.size();
+        int len = LENGTH(v);
         write_int32(len);
 
+	const int* values = LOGICAL(v);
 	for (int i = 0 ; i < len ; i++)
-	  write_int32(v[i] ? (char)1 : (char)0);  
+	  write_byte(values[i] ? (char)1 : (char)0);  
+    }
+
+    // write bool vector as a packed bitset, followed by a bitset of NA positions if any are present
+    void write_bit_array (SEXP v)
+    {
+        int len = LENGTH(v);
+        write_int32(len);
+
+	const int* values = LOGICAL(v);
+	bool hasNA = false;
+	for (int i = 0 ; i < len && !hasNA ; i++)
+	    hasNA = values[i] == NA_LOGICAL;
+
+	write_byte (hasNA ? (char)BitArrayNA : (char)0);
+	write_bits (values, len, false);
+	if (hasNA)
+	    write_bits (values, len, true);
+    }
+
+    // write float64 vector as float32 (with NA preserved)
+    void write_float32_array (SEXP v)
+    {
+        int len = LENGTH(v);
+        write_int32(len);
+
+	const double* values = REAL(v);
+	float na;
+	uint32_t nabits = Float32NA;
+	memcpy (&na, &nabits, sizeof(float));
+
+	float chunk[2048];
+	for (int i = 0 ; i < len ; )
+	{
+	    int n = std::min (2048, len - i);
+	    for (int k = 0 ; k < n ; k++)
+	        chunk[k] = (float)values[i+k];
+	    for (int k = 0 ; k < n ; k++)
+	        if (std::isnan (chunk[k]) && R_IsNA (values[i+k])) chunk[k] = na;
+
+	    write_bytes (chunk, n * sizeof(float));
+	    i += n;
+	}
     }
 
     // write int32 vector 
-    void write_int32_array (const IntegerVector& v)
+    void write_int32_array (SEXP v)
     {
-        int len = v.size();
+        int len = LENGTH(v);
         write_int32(len);
+	write_bytes (INTEGER(v), (size_t)len * sizeof(int32_t));
+    }
 
-	for (int i = 0 ; i < len ; i++)
-	    write_int32(v[i]);  
+    // write byte vector
+    void write_byte_array (SEXP v)
+    {
+        int len = LENGTH(v);
+        write_int32(len);
+	write_bytes (RAW(v), (size_t)len);
     }
 
-    // write float64 vector 
-    void write_float64_array (const NumericVector& v)
+    // write int64 vector (bit64 integer64 layout: int64 values stored in double storage)
+    void write_int64_array (SEXP v)
     {
-        int len = v.size();
+        int len = LENGTH(v);
         write_int32(len);
+	write_bytes (REAL(v), (size_t)len * sizeof(int64_t));
+    }
 
-	for (int i = 0 ; i < len ; i++)
-	    write_float64(v[i]);  
+    // write float64 vector 
+    void write_float64_array (SEXP v)
+    {
+        int len = LENGTH(v);
+        write_int32(len);
+	write_bytes (REAL(v), (size_t)len * sizeof(double));
     }
 
     // write string vector 
-    void write_string_array (const CharacterVector& v)
+    void write_string_array (SEXP v)
     {
-        int len = v.size();
+        int len = LENGTH(v);
         write_int32(len);
 
 	for (int i = 0 ; i < len ; i++)
-	    write_string(v[i]);  
+	    write_charsxp (STRING_ELT (v, i));
+    }
+  
+    // pack logical values 64 to a word (lsb first), selecting either the TRUE or the NA positions
+    void write_bits (const int* values, int len, bool na)
+    {
+	uint64_t words[512];
+	size_t remaining = ((size_t)len + 7) / 8;
+
+	for (int i = 0 ; i < len ; )
+	{
+	    int nwords = 0;
+	    for ( ; nwords < 512 && i < len ; nwords++)
+	    {
+		int n = std::min (64, len - i);
+		uint64_t word = 0;
+		if (na)
+		{
+		    for (int k = 0 ; k < n ; k++)
+			word |= (uint64_t)(values[i+k] == NA_LOGICAL) << k;
+		}
+		else
+		{
+		    for (int k = 0 ; k < n ; k++)
+			word |= (uint64_t)(values[i+k] != 0 && values[i+k] != NA_LOGICAL) << k;
+		}
+		words[nwords] = word;
+		i += n;
+	    }
+
+	    size_t nbytes = std::min (remaining, (size_t)nwords * sizeof(uint64_t));
+	    write_bytes (words, nbytes);
+	    remaining -= nbytes;
+	}
+    }
+
+    // write a block of raw bytes
+    void write_bytes (const void* src, size_t nbytes)
+    {
+        const byte* in = reinterpret_cast<const byte*>(src);
+
+	// diverted into memory: grow to fit
+	if (_diverted)
+	{
+	    reserve (_len + nbytes);
+	    memcpy (_buffer + _len, in, nbytes);
+	    _len += (int)nbytes;
+	    return;
+	}
+
+	// copy into the buffer if there is room
+	if ((size_t)(_buflen - _len) >= nbytes)
+	{
+	    memcpy (_buffer + _len, in, nbytes);
+	    _len += (int)nbytes;
+	    return;
+	}
+
+	flush();
+	if (nbytes < (size_t)_buflen)
+	{
+	    memcpy (_buffer, in, nbytes);
+	    _len = (int)nbytes;
+	    return;
+	}
+
+	// large block: send directly from the source memory, bypassing the buffer
+	while (nbytes > 0)
+	{
+	    int amount = (int)min (nbytes, (size_t)(1 << 30));
+	    int done = _sock->write (in, amount);
+	    if (done <= 0)
+	        throw std::runtime_error("problem communicating with CLR, could not complete message");
+
+	    _written += done;
+
+	    in += done;
+	    nbytes -= done;
+	}
     }
   
     // close stream
@@ -193,18 +341,88 @@ class BufferedSocketWriter
     // flush stream
     void flush ()
     {
+       if (_len == 0)
+	   return;
+       if (_diverted)
+       {
+	   // called when the buffer is full: make room rather than sending
+	   reserve ((size_t)_buflen * 2);
+	   return;
+       }
+
        int done = _sock->write(_buffer, _len);
        if (done < _len)
 	   throw std::runtime_error("problem communicating with CLR, could not complete message");
+       _written += _len;
        _len = 0;
     }
 
+    // total # of bytes written to the stream (including those still buffered)
+    uint64_t bytes () const
+    {
+        return _written + _len;
+    }
+
+    // divert writes into memory until end_block(), so that a value can be examined (and compressed) before sending
+    void begin_block ()
+    {
+        if (_diverted)
+	    throw std::runtime_error ("BufferedSocketWriter: block already started");
+
+	_outer = _buffer;
+	_outerlen = _len;
+	_outercap = _buflen;
+
+	_buffer = _block.data();
+	_buflen = (int)_block.size();
+	_len = 0;
+	_diverted = true;
+	reserve (8192);
+    }
+
+    // stop diverting writes, returning the # of bytes written to block() since begin_block()
+    size_t end_block ()
+    {
+        size_t len = _len;
+	_buffer = _outer;
+	_len = _outerlen;
+	_buflen = _outercap;
+	_diverted = false;
+	return len;
+    }
+
+    // bytes written while diverted (valid until the next begin_block())
+    const byte* block () const
+    {
+        return _block.data();
+    }
+
   
   private:
-    RTcpClient* _sock; 
+
+    // grow block to hold at least n bytes
+    void reserve (size_t n)
+    {
+        if (n <= _block.size())
+	    return;
+
+	_block.resize (max (n, _block.size() * 2));
+	_buffer = _block.data();
+	_buflen = (int)_block.size();
+    }
+
+  private:
+    RTransport* _sock; 
     byte*       _buffer;
     int         _buflen;
     int         _len;
+    uint64_t    _written;
+
+    bool              _diverted;
+    std::vector<byte> _block;
+    byte*             _outer;
+    int               _outerlen;
+    int               _outercap;
 };
 
 #endif
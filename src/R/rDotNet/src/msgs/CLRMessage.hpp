@@ -54,14 +54,17 @@ class CLRMessage
     static const char TypeVector             = (char)21;
     static const char TypeMatrix             = (char)22;
     static const char TypeException          = (char)23;
+    static const char TypeCompressed         = (char)24;
 
     static const char TypeBoolArray          = (char)101;
     static const char TypeByteArray          = (char)102;
+    static const char TypeFloat32Array       = (char)103;
     static const char TypeInt32Array         = (char)105;
     static const char TypeInt64Array         = (char)106;
     static const char TypeFloat64Array       = (char)107;
     static const char TypeStringArray        = (char)108;
     static const char TypeObjectArray        = (char)109;
+    static const char TypeBitArray           = (char)110;
   
     static const char TypeCreate             = (char)201;
     static const char TypeCallStaticMethod   = (char)202;
@@ -76,6 +79,13 @@ class CLRMessage
     static const char TypeRelease            = (char)211;
     static const char TypeTemplateReq        = (char)212;
     static const char TypeTemplateReply      = (char)213;
+    static const char TypeReleaseBatch       = (char)214;
+    static const char TypePrepare            = (char)215;
+    static const char TypeInvoke             = (char)216;
+    static const char TypeCompression        = (char)217;
+    static const char TypeChain              = (char)218;
+    static const char TypeGetProperties      = (char)219;
+    static const char TypeProject            = (char)220;
   
     CLRMessage (char mtype, CLRApi* api)
       : _mtype(mtype), _api(api) { }
@@ -88,6 +98,12 @@ class CLRMessage
         return _mtype;
     }
 
+    // name of the method or member addressed by this message (for statistics)
+    virtual std::string name()
+    {
+        return std::string();
+    }
+
     // R value associated with this message
     virtual RValue rvalue()
     {
@@ -42,6 +42,12 @@ class CLRCallMethod : public CLRMessage
     {
     }
 
+    // name of the method or member addressed
+    std::string name()
+    {
+        return _method;
+    }
+
     // serialize object to stream
     void serialize (BufferedSocketWriter& stream)
     {
@@ -55,11 +61,7 @@ class CLRCallMethod : public CLRMessage
 
 	CLRFactory* factory = _api->factory();
 	for (int i = 0 ; i < argc ; i++)
-	{
-	    CLRMessage* msg = factory->messageByValue(_argv[i]);
-	    msg->serialize(stream);
-	    delete msg;
-	}
+	    factory->serializeValue(stream, _argv[i]);
     }
 
   
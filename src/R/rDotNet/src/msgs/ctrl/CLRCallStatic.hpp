@@ -40,6 +40,12 @@ class CLRCallStatic : public CLRMessage
     CLRCallStatic (CLRApi* api, const std::string klass, const std::string& method, const List& argv)
       : CLRMessage(CLRMessage::TypeCallStaticMethod, api), _class(klass), _method(method), _argv(argv) { }
 
+    // name of the method or member addressed
+    std::string name()
+    {
+        return _class + "." + _method;
+    }
+
     // serialize object to stream
     void serialize (BufferedSocketWriter& stream)
     {
@@ -53,11 +59,7 @@ class CLRCallStatic : public CLRMessage
 
 	CLRFactory* factory = _api->factory();
 	for (int i = 0 ; i < argc ; i++)
-	{
-	    CLRMessage* msg = factory->messageByValue(_argv[i]);
-	    msg->serialize(stream);
-	    delete msg;
-	}
+	    factory->serializeValue(stream, _argv[i]);
     }
 
   
@@ -0,0 +1,98 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+#ifndef CLR_CHAIN
+#define CLR_CHAIN
+
+#include <cstdlib>
+#include <string>
+#include <Rcpp.h>
+#include "CLRFactory.hpp"
+
+using namespace std;
+
+
+//
+//  Chained call Message: method calls and property or indexed gets, each applied to the result of the
+//  previous, evaluated by the CLR in one request with only the final value returned
+//
+class CLRChain : public CLRMessage
+{
+  public:
+
+    // step kinds
+    static const char StepCall               = (char)0;
+    static const char StepGet                = (char)1;
+    static const char StepIndex              = (char)2;
+  
+    CLRChain (CLRApi* api, const std::string& classname, SEXP obj, const IntegerVector& kinds, const CharacterVector& names, const List& argv)
+      : CLRMessage(CLRMessage::TypeChain, api), _class(classname), _obj(obj), _kinds(kinds), _names(names), _argv(argv) { }
+
+    // names of the steps, as a path
+    std::string name()
+    {
+        std::string path;
+	for (int i = 0 ; i < _names.size() ; i++)
+	{
+	    if (i > 0)
+	        path += ".";
+	    path += CHAR(STRING_ELT (_names, i));
+	}
+	return path;
+    }
+
+    // serialize object to stream
+    void serialize (BufferedSocketWriter& stream)
+    {
+        CLRMessage::serialize (stream);
+	CLRFactory* factory = _api->factory();
+
+	// starting class (for a static first step) or object
+	stream.write_string(_class);
+	factory->serializeValue(stream, _obj);
+
+	// steps
+	int nsteps = _kinds.size();
+	stream.write_int16((int16_t)nsteps);
+	for (int i = 0 ; i < nsteps ; i++)
+	{
+	    stream.write_byte((char)INTEGER(_kinds)[i]);
+	    stream.write_string(Rf_translateCharUTF8 (STRING_ELT (_names, i)));
+
+	    SEXP args = VECTOR_ELT (_argv, i);
+	    int argc = LENGTH(args);
+	    stream.write_int16((int16_t)argc);
+	    for (int j = 0 ; j < argc ; j++)
+	        factory->serializeValue(stream, VECTOR_ELT (args, j));
+	}
+    }
+
+  
+  protected:
+    std::string      _class;
+    RObject          _obj;
+    IntegerVector    _kinds;
+    CharacterVector  _names;
+    List             _argv;
+};
+
+#endif
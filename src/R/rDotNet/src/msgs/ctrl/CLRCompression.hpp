@@ -0,0 +1,57 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#ifndef CLR_COMPRESSION
+#define CLR_COMPRESSION
+
+#include <cstdlib>
+#include <Rcpp.h>
+#include "CLRFactory.hpp"
+#include "Compression.hpp"
+
+using namespace std;
+
+
+//
+//  Compression Message: enables compressed values of at least the given size in either direction (0 to disable)
+//
+class CLRCompression : public CLRMessage
+{
+  public:
+  
+    CLRCompression (CLRApi* api, int32_t threshold)
+      : CLRMessage(CLRMessage::TypeCompression, api), _threshold(threshold) { }
+
+    // serialize object to stream
+    void serialize (BufferedSocketWriter& stream)
+    {
+        CLRMessage::serialize (stream);
+	stream.write_int32(_threshold);
+	stream.write_byte((char)RCompression::Deflate);
+    }
+  
+  protected:
+    int32_t  _threshold;
+};
+
+#endif
@@ -40,6 +40,12 @@ class CLRCreateObject : public CLRMessage
     CLRCreateObject (CLRApi* api, const std::string klass, const List& argv)
       : CLRMessage(CLRMessage::TypeCreate, api), _class(klass), _argv(argv) { }
 
+    // name of the method or member addressed
+    std::string name()
+    {
+        return _class;
+    }
+
     // serialize object to stream
     void serialize (BufferedSocketWriter& stream)
     {
@@ -52,11 +58,7 @@ class CLRCreateObject : public CLRMessage
 
 	CLRFactory* factory = _api->factory();
 	for (int i = 0 ; i < argc ; i++)
-	{
-	    CLRMessage* msg = factory->messageByValue(_argv[i]);
-	    msg->serialize(stream);
-	    delete msg;
-	}
+	    factory->serializeValue(stream, _argv[i]);
     }
 
   
@@ -0,0 +1,74 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+#ifndef CLR_GETPROPS
+#define CLR_GETPROPS
+
+#include <cstdlib>
+#include <Rcpp.h>
+#include "CLRFactory.hpp"
+
+using namespace std;
+
+
+//
+//  Get Properties Message: several properties of an object, read in one request
+//
+class CLRGetProperties : public CLRMessage
+{
+  public:
+  
+    CLRGetProperties (CLRApi* api, int32_t objectId, const CharacterVector& properties)
+      : CLRMessage(CLRMessage::TypeGetProperties, api), _objectId(objectId),
+	_properties(properties) { }
+
+    // names of the properties addressed
+    std::string name()
+    {
+        std::string names;
+	for (int i = 0 ; i < _properties.size() ; i++)
+	{
+	    if (i > 0)
+	        names += ",";
+	    names += CHAR(STRING_ELT (_properties, i));
+	}
+	return names;
+    }
+
+    // serialize object to stream
+    void serialize (BufferedSocketWriter& stream)
+    {
+        CLRMessage::serialize (stream);
+	stream.write_int32(_objectId);
+
+	int n = _properties.size();
+	stream.write_int16((int16_t)n);
+	for (int i = 0 ; i < n ; i++)
+	    stream.write_string(Rf_translateCharUTF8 (STRING_ELT (_properties, i)));
+    }
+  
+  protected:
+    int32_t           _objectId;
+    CharacterVector   _properties;
+};
+
+#endif
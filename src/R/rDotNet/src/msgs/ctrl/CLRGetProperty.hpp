@@ -41,6 +41,12 @@ class CLRGetProperty : public CLRMessage
       : CLRMessage(CLRMessage::TypeGetProperty, api), _objectId(objectId),
 	_property(property) { }
 
+    // name of the method or member addressed
+    std::string name()
+    {
+        return _property;
+    }
+
     // serialize object to stream
     void serialize (BufferedSocketWriter& stream)
     {
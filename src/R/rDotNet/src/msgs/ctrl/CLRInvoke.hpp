@@ -0,0 +1,71 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+#ifndef CLR_INVOKE
+#define CLR_INVOKE
+
+#include <cstdlib>
+#include <string>
+#include <Rcpp.h>
+#include "CLRFactory.hpp"
+
+using namespace std;
+
+
+//
+//  Invoke prepared method Message
+//
+class CLRInvoke : public CLRMessage
+{
+  public:
+  
+    CLRInvoke (CLRApi* api, int32_t handle, const List& argv)
+      : CLRMessage(CLRMessage::TypeInvoke, api), _handle(handle), _argv(argv) { }
+
+    // name of the method addressed (by handle)
+    std::string name()
+    {
+        return "#" + std::to_string ((long long)_handle);
+    }
+
+    // serialize object to stream
+    void serialize (BufferedSocketWriter& stream)
+    {
+        CLRMessage::serialize (stream);
+	stream.write_int32(_handle);
+
+	// argv
+	int argc = _argv.size();
+	stream.write_int16((int16_t)argc);
+
+	CLRFactory* factory = _api->factory();
+	for (int i = 0 ; i < argc ; i++)
+	    factory->serializeValue(stream, _argv[i]);
+    }
+
+  
+  protected:
+    int32_t       _handle;
+    List          _argv;
+};
+
+#endif
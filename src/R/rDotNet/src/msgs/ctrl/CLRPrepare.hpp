@@ -0,0 +1,76 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+#ifndef CLR_PREPARE
+#define CLR_PREPARE
+
+#include <cstdlib>
+#include <Rcpp.h>
+#include "CLRFactory.hpp"
+
+using namespace std;
+
+
+//
+//  Prepare method Message (reply is an integer handle for CLRInvoke)
+//
+class CLRPrepare : public CLRMessage
+{
+  public:
+  
+    CLRPrepare (CLRApi* api, const std::string klass, const std::string& method, SEXP argtypes)
+      : CLRMessage(CLRMessage::TypePrepare, api), _class(klass), _method(method), _argtypes(argtypes) { }
+
+    // name of the method or member addressed
+    std::string name()
+    {
+        return _class + "." + _method;
+    }
+
+    // serialize object to stream
+    void serialize (BufferedSocketWriter& stream)
+    {
+        CLRMessage::serialize (stream);
+	stream.write_string(_class);
+	stream.write_string(_method);
+
+	// argument types (-1 if not given)
+	if (Rf_isNull(_argtypes))
+	{
+	    stream.write_int32(-1);
+	    return;
+	}
+
+	CharacterVector types (_argtypes);
+	stream.write_int32((int32_t)types.size());
+	for (int i = 0 ; i < types.size() ; i++)
+	    stream.write_string(Rcpp::as<std::string>(types[i]));
+    }
+
+  
+  protected:
+    std::string   _class;
+    std::string   _method;
+    SEXP          _argtypes;
+};
+
+#endif
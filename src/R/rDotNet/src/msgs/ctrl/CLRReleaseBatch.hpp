@@ -0,0 +1,56 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+#ifndef CLR_RELEASE_BATCH
+#define CLR_RELEASE_BATCH
+
+#include <cstdlib>
+#include <vector>
+#include <Rcpp.h>
+#include "CLRFactory.hpp"
+
+using namespace std;
+
+
+//
+//  Release Batch Message (releases queued by the GC finalizer)
+//
+class CLRReleaseBatch : public CLRMessage
+{
+  public:
+  
+    CLRReleaseBatch (CLRApi* api, const std::vector<int32_t>& objectIds)
+      : CLRMessage(CLRMessage::TypeReleaseBatch, api), _objectIds(objectIds) { }
+
+    // serialize object to stream
+    void serialize (BufferedSocketWriter& stream)
+    {
+        CLRMessage::serialize (stream);
+	stream.write_int32((int32_t)_objectIds.size());
+	stream.write_bytes(_objectIds.data(), _objectIds.size() * sizeof(int32_t));
+    }
+  
+  protected:
+    const std::vector<int32_t>&  _objectIds;
+};
+
+#endif
@@ -41,6 +41,12 @@ class CLRSetProperty : public CLRMessage
       : CLRMessage(CLRMessage::TypeSetProperty, api), _objectId(objectId),
 	_property(property), _value(value) { }
 
+    // name of the method or member addressed
+    std::string name()
+    {
+        return _property;
+    }
+
     // serialize object to stream
     void serialize (BufferedSocketWriter& stream)
     {
@@ -49,9 +55,7 @@ class CLRSetProperty : public CLRMessage
 	stream.write_string(_property);
 
 	CLRFactory* factory = _api->factory();
-	CLRMessage* vmsg = factory->messageByValue(_value);
-	vmsg->serialize (stream);
-	delete vmsg;
+	factory->serializeValue(stream, _value);
     }
 
   
@@ -52,7 +52,7 @@ class CLRBoolArray : public CLRValue<LogicalVector>
     // deserialize object from stream
     void deserialize (BufferedSocketReader& stream)
     {
-	_value = stream.read_bool_array();
+	_value = new LogicalVector (stream.read_bool_array());
     }
 };
 
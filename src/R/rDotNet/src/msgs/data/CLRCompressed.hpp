@@ -0,0 +1,124 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#ifndef CLR_COMPRESSED
+#define CLR_COMPRESSED
+
+#include <cstdlib>
+#include <vector>
+#include "msgs/CLRMessage.hpp"
+#include "Compression.hpp"
+
+using namespace std;
+
+
+//
+// Compressed value envelope, wrapping the complete message for a value (see Compression.hpp for the layout)
+//
+//  On receipt the decompressed message is pushed back onto the stream, to be read in place of the envelope.
+//
+class CLRCompressed : public CLRMessage
+{
+  public:
+
+    CLRCompressed (CLRApi* api, int width = 1, const byte* data = nullptr, size_t len = 0)
+      : CLRMessage(CLRMessage::TypeCompressed, api), _width(width), _data(data), _len(len)
+    {
+    }
+
+    // element width to shuffle by for the given value type (0 if the type is not compressed)
+    static int width (char mtype)
+    {
+        switch (mtype)
+	{
+	case CLRMessage::TypeVector:
+	case CLRMessage::TypeMatrix:
+	case CLRMessage::TypeFloat64Array:
+	case CLRMessage::TypeInt64Array:
+	    return 8;
+	case CLRMessage::TypeInt32Array:
+	case CLRMessage::TypeFloat32Array:
+	    return 4;
+	case CLRMessage::TypeBoolArray:
+	case CLRMessage::TypeBitArray:
+	case CLRMessage::TypeByteArray:
+	case CLRMessage::TypeStringArray:
+	    return 1;
+	default:
+	    return 0;
+	}
+    }
+
+    // serialize object to stream
+    void serialize (BufferedSocketWriter& stream)
+    {
+        std::vector< std::vector<byte> > chunks;
+	RCompression::encode (_data, _len, _width, chunks);
+
+        CLRMessage::serialize (stream);
+	stream.write_byte ((char)RCompression::Deflate);
+	stream.write_byte ((char)_width);
+	stream.write_int32 ((int32_t)_len);
+	stream.write_int32 (RCompression::ChunkSize);
+	for (size_t i = 0 ; i < chunks.size() ; i++)
+	{
+	    stream.write_int32 ((int32_t)chunks[i].size());
+	    stream.write_bytes (chunks[i].data(), chunks[i].size());
+	}
+    }
+
+    // deserialize object from stream, pushing the decompressed message back onto it
+    void deserialize (BufferedSocketReader& stream)
+    {
+        char codec = stream.read_byte();
+	if (codec != (char)RCompression::Deflate)
+	    throw std::runtime_error ("CLRCompressed: unknown compression codec");
+
+	int width = stream.read_byte();
+	int len = stream.read_int32();
+	int chunksize = stream.read_int32();
+	if (len < 0 || chunksize <= 0)
+	    throw std::runtime_error ("CLRCompressed: bad envelope");
+
+	std::vector< std::vector<byte> > chunks ((len + (size_t)chunksize - 1) / chunksize);
+	for (size_t i = 0 ; i < chunks.size() ; i++)
+	{
+	    int clen = stream.read_int32();
+	    if (clen < 0)
+	        throw std::runtime_error ("CLRCompressed: bad envelope");
+	    chunks[i].resize (clen);
+	    stream.read_bytes (chunks[i].data(), chunks[i].size());
+	}
+
+	std::vector<byte> data;
+	RCompression::decode (chunks, len, chunksize, width, data);
+	stream.push (data);
+    }
+
+  private:
+    int          _width;
+    const byte*  _data;
+    size_t       _len;
+};
+
+#endif
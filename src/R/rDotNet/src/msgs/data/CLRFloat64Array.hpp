@@ -52,7 +52,7 @@ class CLRFloat64Array : public CLRValue<NumericVector>
     // deserialize object from stream
     void deserialize (BufferedSocketReader& stream)
     {
-	_value = stream.read_float64_array();
+	_value = new NumericVector (stream.read_float64_array());
     }
 };
 
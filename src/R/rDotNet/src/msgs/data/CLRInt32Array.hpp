@@ -52,7 +52,7 @@ class CLRInt32Array : public CLRValue<IntegerVector>
     // deserialize object from stream
     void deserialize (BufferedSocketReader& stream)
     {
-	_value = stream.read_int32_array();
+	_value = new IntegerVector (stream.read_int32_array());
     }
 };
 
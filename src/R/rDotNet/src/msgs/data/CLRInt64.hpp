@@ -25,13 +25,14 @@
 #define CLR_INT64
 
 #include <cstdlib>
+#include <cstring>
 #include "msgs/CLRValue.hpp"
 
 using namespace std;
 
 
 //
-// Int64 value
+// Int64 value, given to R as a bit64 integer64 scalar (int64 value in double storage)
 //
 class CLRInt64 : public CLRValue<int64_t>
 {
@@ -42,6 +43,18 @@ class CLRInt64 : public CLRValue<int64_t>
     {
     }
 
+    // R value associated with this message
+    RValue rvalue()
+    {
+        if (_value == NULL)
+	    throw std::runtime_error ("CLRMessage: no value assigned to message");
+
+	NumericVector vec (1);
+	memcpy (REAL(vec), _value, sizeof(int64_t));
+	vec.attr("class") = "integer64";
+	return RValue (Rcpp::wrap (vec));
+    }
+
     // serialize object to stream
     void serialize (BufferedSocketWriter& stream)
     {
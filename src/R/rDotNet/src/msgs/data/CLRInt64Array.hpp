@@ -0,0 +1,70 @@
+//
+// General:
+//      This file is part of .NET Bridge
+//
+// Copyright:
+//      2010 Jonathan Shore
+//	2017 Jonathan Shore and Contributors
+//
+// License:
+//      Licensed under the Apache License, Version 2.0 (the "License");
+//      you may not use this file except in compliance with the License.
+//      You may obtain a copy of the License at:
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+//      Unless required by applicable law or agreed to in writing, software
+//      distributed under the License is distributed on an "AS IS" BASIS,
+//      WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+//      See the License for the specific language governing permissions and
+//      limitations under the License.
+//
+
+
+#ifndef CLR_INT64_ARRAY
+#define CLR_INT64_ARRAY
+
+#include <cstdlib>
+#include "msgs/CLRValue.hpp"
+
+using namespace std;
+
+
+//
+// Int64 Vector, held as a bit64 integer64 vector (int64 values in double storage)
+//
+class CLRInt64Array : public CLRValue<NumericVector>
+{
+  public:
+
+    CLRInt64Array (CLRApi* api, NumericVector* value = nullptr)
+      : CLRValue(CLRMessage::TypeInt64Array, api, value)
+    {
+    }
+
+    // R value associated with this message
+    RValue rvalue()
+    {
+        if (_value == NULL)
+	    throw std::runtime_error ("CLRMessage: no value assigned to message");
+
+	_value->attr("class") = "integer64";
+	return RValue (Rcpp::wrap (*_value));
+    }
+
+    // serialize object to stream
+    void serialize (BufferedSocketWriter& stream)
+    {
+        assert (_value != NULL);
+        CLRMessage::serialize (stream);
+	stream.write_int64_array (*_value);
+    }
+
+    // deserialize object from stream
+    void deserialize (BufferedSocketReader& stream)
+    {
+	_value = new NumericVector (stream.read_int64_array());
+    }
+};
+
+#endif
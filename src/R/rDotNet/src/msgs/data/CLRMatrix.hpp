@@ -48,96 +48,80 @@ class CLRMatrix : public CLRValue<Rcpp::NumericMatrix>
     {
         assert (_value != NULL);
         CLRMessage::serialize (stream);
+	write (stream, *_value);
+    }
 
-	const NumericMatrix& mat = *_value;
-	
-	// get row and column names
-	Rcpp::Function rownames("rownames");
-	Rcpp::Function colnames("colnames");
-
-	RObject rn = rownames(mat);
-	RObject cn = colnames(mat);
-
-	// output row names if existant
-	if (!rn.isNULL())
-	{
-	    StringVector rnames(rn.get__());
-	    stream.write_int32(rnames.size());
-	    for (int i = 0; i < rnames.size(); i++)
-	        stream.write_string(rnames[i]);
-	} else
-	    stream.write_int32(0);
-
-	// output column names if existant
-	if (!cn.isNULL())
-	{
-	    StringVector cnames(cn.get__());
-	    stream.write_int32(cnames.size());
-	    for (int i = 0; i < cnames.size(); i++)
-	        stream.write_string(cnames[i]);
-	} else
-	    stream.write_int32(0);
+    // write matrix body straight from an R numeric matrix
+    static void write (BufferedSocketWriter& stream, SEXP mat)
+    {
+	// output row and column names (if existant) straight from the dimnames attribute
+	SEXP dimnames = Rf_getAttrib (mat, R_DimNamesSymbol);
+	write_names (stream, Rf_isNull(dimnames) ? R_NilValue : VECTOR_ELT(dimnames, 0));
+	write_names (stream, Rf_isNull(dimnames) ? R_NilValue : VECTOR_ELT(dimnames, 1));
 
 	// write out dimensions
-	int nrow = mat.nrow();
-	int ncol = mat.ncol();
+	int nrow = Rf_nrows(mat);
+	int ncol = Rf_ncols(mat);
 	stream.write_int32(nrow);
 	stream.write_int32(ncol);
 
-	// write data
-        for (int ci = 0 ; ci < ncol ; ci++)
-        {
-            for (int ri = 0 ; ri < nrow ; ri++)
-            {
-	        stream.write_float64 (mat(ri,ci));
-	    }
-        }
+	// write data (R matrices are column-major & contiguous, as is the wire format)
+	stream.write_bytes (REAL(mat), (size_t)nrow * ncol * sizeof(double));
     }
 
     // deserialize object from stream
     void deserialize (BufferedSocketReader& stream)
     {
         // read matrix indices
-        CharacterVector rn;
-        CharacterVector cn;
-      
-	int rnlen = stream.read_int32();
-	if (rnlen > 0)
-	{
-	    for (int i = 0 ; i < rnlen ; i++)
-	        rn.push_back (stream.read_string());
-	}
-	
-	int cnlen = stream.read_int32();
-	if (cnlen > 0)
-	{
-	    for (int i = 0 ; i < cnlen ; i++)
-	        cn.push_back (stream.read_string());
-	}
+        CharacterVector rn = read_names (stream);
+        CharacterVector cn = read_names (stream);
 
 	// read matrix dimensions
 	int nrow = stream.read_int32();
 	int ncol = stream.read_int32();
 
-	// create
-	_value = new NumericMatrix (nrow, ncol);
+	// create & read data directly into matrix storage
+	_value = new NumericMatrix (Rcpp::no_init(nrow, ncol));
 	NumericMatrix& mat = *_value;
-
-        for (int ci = 0 ; ci < ncol ; ci++)
-        {
-            for (int ri = 0 ; ri < nrow ; ri++)
-            {
-	        double v = stream.read_float64 ();
-		mat(ri,ci) = v;
-	    }
-        }
+	stream.read_bytes (REAL(mat), (size_t)nrow * ncol * sizeof(double));
 
 	// assign matrix indices if they exist
-	List dimnames = Rcpp::List::create(
-	    rn.size() > 0 ? rn.get__() : R_NilValue,
-	    cn.size() > 0 ? cn.get__() : R_NilValue);
+	if (rn.size() > 0 || cn.size() > 0)
+	{
+	    List dimnames = Rcpp::List::create(
+	        rn.size() > 0 ? rn.get__() : R_NilValue,
+		cn.size() > 0 ? cn.get__() : R_NilValue);
+
+	    mat.attr("dimnames") = dimnames;
+	}
+    }
+
+  private:
+
+    // write index names as UTF-8, NA as null (or 0 length if none)
+    static void write_names (BufferedSocketWriter& stream, SEXP names)
+    {
+        if (Rf_isNull(names))
+	{
+	    stream.write_int32(0);
+	    return;
+	}
+
+	int len = LENGTH(names);
+	stream.write_int32(len);
+	for (int i = 0; i < len; i++)
+	    stream.write_charsxp(STRING_ELT(names, i));
+    }
+
+    // read index names (UTF-8, NA where null)
+    static CharacterVector read_names (BufferedSocketReader& stream)
+    {
+        int len = stream.read_int32();
+	CharacterVector names (Rcpp::no_init(len));
+	for (int i = 0 ; i < len ; i++)
+	    SET_STRING_ELT (names, i, stream.read_charsxp());
 
-	mat.attr("dimnames") = dimnames;
+	return names;
     }
 };
 
@@ -49,34 +49,36 @@ class CLRObjectArray : public CLRValue<List>
     {
         assert (_value != NULL);
         CLRMessage::serialize (stream);
+	write (stream, _api->factory(), *_value);
+    }
 
-	int len = _value->size();
-	CLRFactory* factory = _api->factory();
-	
+    // write list body, each element written directly from its R value
+    static void write (BufferedSocketWriter& stream, CLRFactory* factory, SEXP list)
+    {
+	int len = LENGTH(list);
 	stream.write_int32 (len);
 	for (int i = 0 ; i < len ; i++)
-	{
-	    SEXP obj = (*_value)[i];
-	    RObject robj (obj);
-	    CLRMessage* msg = factory->messageByValue (robj);
-
-	    msg->serialize(stream);
-	    delete msg;
-	}
+	    factory->serializeValue (stream, VECTOR_ELT (list, i));
     }
 
     // deserialize object from stream
     void deserialize (BufferedSocketReader& stream)
     {
         int len = stream.read_int32();
-	_value = new List();
+	_value = new List(len);
 
+	// scalar and array elements are decoded directly, others through their message
 	for (int i = 0 ; i < len ; i++)
 	{
-	    CLRMessage* msg = _api->read();
-	    SEXP value = msg->rvalue();
-	    _value->push_back (value);
+	    SEXP value = NULL;
+	    CLRMessage* msg = _api->read (nullptr, &value);
+	    if (msg == nullptr)
+	    {
+	        SET_VECTOR_ELT (*_value, i, value);
+		continue;
+	    }
 
+	    SET_VECTOR_ELT (*_value, i, msg->rvalue());
 	    delete msg;
 	}
     }
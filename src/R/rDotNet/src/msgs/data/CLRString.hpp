@@ -42,6 +42,15 @@ class CLRString : public CLRValue<std::string>
     {
     }
 
+    // R value associated with this message (text is UTF-8)
+    RValue rvalue()
+    {
+        if (_value == NULL)
+	    throw std::runtime_error ("CLRMessage: no value assigned to message");
+
+	return RValue (Rf_ScalarString (Rf_mkCharLenCE (_value->data(), (int)_value->length(), CE_UTF8)));
+    }
+
     // serialize object to stream
     void serialize (BufferedSocketWriter& stream)
     {
@@ -54,7 +54,7 @@ class CLRStringArray : public CLRValue<CharacterVector>
     // deserialize object from stream
     void deserialize (BufferedSocketReader& stream)
     {
-	_value = stream.read_string_array();
+	_value = new CharacterVector (stream.read_string_array());
     }
 };
 
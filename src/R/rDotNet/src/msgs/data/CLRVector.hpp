@@ -49,52 +49,45 @@ class CLRVector : public CLRValue<Rcpp::NumericVector>
     {
         assert (_value != NULL);
         CLRMessage::serialize (stream);
+	write (stream, *_value);
+    }
 
-	Rcpp::RObject rnames = _value->names();
-	int len = _value->size();
-	if (!rnames.isNULL())
+    // write vector body straight from an R numeric vector
+    static void write (BufferedSocketWriter& stream, SEXP vec)
+    {
+	// index (if any)
+	SEXP names = Rf_getAttrib (vec, R_NamesSymbol);
+	int len = LENGTH(vec);
+	if (!Rf_isNull(names))
 	{
-	    Rcpp::StringVector names (rnames.get__());
-	    stream.write_int32(len);
-	    for (int i = 0 ; i < len; i++)
-	        stream.write_string(names[i]);
-
 	    stream.write_int32(len);
 	    for (int i = 0 ; i < len; i++)
-	        stream.write_float64((*_value)[i]);	    
+	        stream.write_charsxp(STRING_ELT (names, i));
 	}
 	else
-	{
 	    stream.write_int32(0);
-	    stream.write_int32(len);
-	    for (int i = 0 ; i < len; i++)
-	        stream.write_float64((*_value)[i]);	    
-	}
+
+	// values straight from vector storage
+	stream.write_int32(len);
+	stream.write_bytes (REAL(vec), (size_t)len * sizeof(double));
     }
 
     // deserialize object from stream
     void deserialize (BufferedSocketReader& stream)
     {
-        _value = new Rcpp::NumericVector();
+        // read index (if any) straight into a preallocated vector, protected while the values are read
 	int ilen = stream.read_int32();
-	if (ilen > 0)
-	{
-	    std::vector<std::string> index(ilen);
-	    for (int i = 0 ; i < ilen ; i++)
-	        index[i] = stream.read_string();
+	Rcpp::Shield<SEXP> names (Rf_allocVector (STRSXP, ilen));
+	for (int i = 0 ; i < ilen ; i++)
+	    SET_STRING_ELT (names, i, stream.read_charsxp());
 
-	    int vlen = stream.read_int32();
-	    assert(ilen == vlen);
+	// read values directly into vector storage
+	_value = new NumericVector (stream.read_float64_array());
+	if (ilen > 0 && ilen != _value->size())
+	    throw std::runtime_error ("CLRMessage: vector index length does not match vector length");
 
-	    for (int i = 0 ; i < vlen ; i++)
-	        _value->push_back(stream.read_float64(), index[i]);
-	}
-	else
-	{
-	    int vlen = stream.read_int32();
-	    for (int i = 0 ; i < vlen ; i++)
-	        _value->push_back(stream.read_float64());
-	}
+	if (ilen > 0)
+	    Rf_setAttrib (*_value, R_NamesSymbol, names);
     }
 };
 